@@ -0,0 +1,53 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include "../src/core/lime_core.hpp"
+#include "../src/hvs/lime_hvs.hpp"
+#include "../benchmarks/bench_utils.h"
+
+typedef void (*ColorConstancy)(cv::InputArray, cv::OutputArray);
+
+// ------------------------------------------------------------------
+// Color constancy
+// ------------------------------------------------------------------
+
+void BM_ColorConstancy(benchmark::State& state, ColorConstancy func) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& img = bench::colorImage(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        func(img, out);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+
+void colorConstancyHorn(cv::InputArray input, cv::OutputArray output) {
+    lime::colorConstancyHorn(input, output);
+}
+
+void colorConstancyRahman(cv::InputArray input, cv::OutputArray output) {
+    lime::colorConstancyRahman(input, output);
+}
+
+BENCHMARK_CAPTURE(BM_ColorConstancy, Horn, colorConstancyHorn)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_ColorConstancy, Rahman, colorConstancyRahman)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_ColorConstancy, Faugeras, lime::colorConstancyFaugeras)->Apply(bench::sizeArgs);
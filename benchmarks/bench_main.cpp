@@ -0,0 +1,54 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/core/lime_core.hpp"
+
+// * results are written in JSON by default so that they can be compared between runs.
+//   Pass "--benchmark_format=console" to override.
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+    std::string format = "--benchmark_format=json";
+    bool hasFormat = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]).find("--benchmark_format") == 0) {
+            hasFormat = true;
+        }
+    }
+    if (!hasFormat) {
+        args.insert(args.begin() + 1, &format[0]);
+    }
+
+    int nargs = static_cast<int>(args.size());
+    benchmark::Initialize(&nargs, &args[0]);
+    if (benchmark::ReportUnrecognizedArguments(nargs, &args[0])) {
+        return 1;
+    }
+
+    benchmark::AddCustomContext("lime_threads", std::to_string(lime::getNumThreads()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
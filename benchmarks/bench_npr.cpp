@@ -0,0 +1,535 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../src/core/lime_core.hpp"
+#include "../src/npr/lime_npr.hpp"
+#include "../benchmarks/bench_utils.h"
+
+namespace npr = lime::npr;
+namespace filter = lime::npr::filter;
+
+// ------------------------------------------------------------------
+// Edge detection
+// ------------------------------------------------------------------
+
+void BM_EdgeDoG(benchmark::State& state, npr::DoGType type) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    npr::DoGParam param(4.5, 0.5, 0.95, 10.0, type);
+    cv::Mat edge;
+    for (auto _ : state) {
+        npr::edgeDoG(gray, edge, param);
+        benchmark::DoNotOptimize(edge.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_EdgeDoG, XDoG, npr::EDGE_XDOG)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_EdgeDoG, FDoG, npr::EDGE_FDOG)->Apply(bench::sizeArgs);
+
+// ------------------------------------------------------------------
+// Line integral convolution
+// ------------------------------------------------------------------
+
+void BM_Lic(benchmark::State& state, npr::LicAlgo algo) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    const cv::Mat& vfield = bench::vectorField(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        npr::lic(out, gray, vfield, 20, algo);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_Lic, Classic, npr::LIC_CLASSIC)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Lic, Eularian, npr::LIC_EULARIAN)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Lic, RungeKutta, npr::LIC_RUNGE_KUTTA)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Lic, Fast, npr::LIC_FAST)->Apply(bench::sizeArgs);
+
+void BM_LicCompact(benchmark::State& state, npr::LicAlgo algo) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    const npr::CompactVectorField vfield(bench::vectorField(size));
+    cv::Mat out;
+    for (auto _ : state) {
+        npr::lic(out, gray, vfield, 20, algo);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_LicCompact, Eularian, npr::LIC_EULARIAN)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_LicCompact, RungeKutta, npr::LIC_RUNGE_KUTTA)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_LicCompact, Fast, npr::LIC_FAST)->Apply(bench::sizeArgs);
+
+// streamlines traced once and reused by every image
+void BM_LicCached(benchmark::State& state, npr::LicAlgo algo) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    const npr::StreamlineCache cache(bench::vectorField(size), 20, algo);
+    cv::Mat out;
+    for (auto _ : state) {
+        npr::lic(out, gray, cache);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_LicCached, Classic, npr::LIC_CLASSIC)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_LicCached, Eularian, npr::LIC_EULARIAN)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_LicCached, RungeKutta, npr::LIC_RUNGE_KUTTA)->Apply(bench::sizeArgs);
+
+// 16 frames of animated LIC along cached streamlines
+void BM_LicAnimation(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    const npr::StreamlineCache cache(bench::vectorField(size), 20, npr::LIC_EULARIAN);
+    for (auto _ : state) {
+        npr::licAnimation(gray, cache, 16, [](int, const cv::Mat& frame) {
+            benchmark::DoNotOptimize(frame.data);
+        });
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_LicAnimation)->Apply(bench::sizeArgs);
+
+// ------------------------------------------------------------------
+// Vector field
+// ------------------------------------------------------------------
+
+void BM_VectorField(benchmark::State& state, npr::VFieldType type) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat angles;
+    for (auto _ : state) {
+        npr::calcVectorField(gray, angles, 5, type);
+        benchmark::DoNotOptimize(angles.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_VectorField, SST, npr::VECTOR_SST)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_VectorField, ETF, npr::VECTOR_ETF)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_VectorField, ETFSeparable, npr::VECTOR_ETF_SEPARABLE)->Apply(bench::sizeArgs);
+
+// tangent vectors through the angles and angle2vector, or directly from the tensors
+void BM_TangentVectors(benchmark::State& state, bool direct) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat angles, vfield;
+    for (auto _ : state) {
+        if (direct) {
+            npr::calcVectorField(gray, vfield, 5, npr::VECTOR_SST, npr::EDGE_SOBEL, npr::VFIELD_VECTORS);
+        } else {
+            npr::calcVectorField(gray, angles, 5, npr::VECTOR_SST);
+            npr::angle2vector(angles, vfield);
+        }
+        benchmark::DoNotOptimize(vfield.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_TangentVectors, ThroughAngles, false)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_TangentVectors, Direct, true)->Apply(bench::sizeArgs);
+
+void BM_AngleConversion(benchmark::State& state, bool toVector) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& vfield = bench::vectorField(size);
+    cv::Mat angles, vectors;
+    npr::vector2angle(vfield, angles);
+    for (auto _ : state) {
+        if (toVector) {
+            npr::angle2vector(angles, vectors);
+            benchmark::DoNotOptimize(vectors.data);
+        } else {
+            npr::vector2angle(vfield, angles);
+            benchmark::DoNotOptimize(angles.data);
+        }
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_AngleConversion, Vector2Angle, false)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_AngleConversion, Angle2Vector, true)->Apply(bench::sizeArgs);
+
+void BM_ImageAnalysis(benchmark::State& state, npr::EdgeDetector edgeDetector) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    for (auto _ : state) {
+        npr::ImageAnalysis analysis(gray, edgeDetector);
+        benchmark::DoNotOptimize(analysis.magnitude().data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_ImageAnalysis, Sobel, npr::EDGE_SOBEL)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_ImageAnalysis, Rotational, npr::EDGE_ROTATIONAL)->Apply(bench::sizeArgs);
+
+void BM_RotationalGradient(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat gx, gy;
+    for (auto _ : state) {
+        npr::rotationalGradient(gray, gx, gy);
+        benchmark::DoNotOptimize(gy.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_RotationalGradient)->Apply(bench::sizeArgs);
+
+// SST and ETF of the same image sharing one analysis
+void BM_SharedAnalysis(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat sst, etf;
+    for (auto _ : state) {
+        const npr::ImageAnalysis analysis(gray);
+        npr::calcVectorField(analysis, sst, 5, npr::VECTOR_SST);
+        npr::calcVectorField(analysis, etf, 5, npr::VECTOR_ETF_SEPARABLE);
+        benchmark::DoNotOptimize(etf.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_SharedAnalysis)->Apply(bench::sizeArgs);
+
+// full resolution and pyramid at the large kernel of flow_field_design
+void BM_VectorFieldLarge(benchmark::State& state, npr::VFieldType type, bool pyramid) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat angles;
+    for (auto _ : state) {
+        if (pyramid) {
+            npr::calcVectorFieldPyramid(gray, angles, 21, type);
+        } else {
+            npr::calcVectorField(gray, angles, 21, type);
+        }
+        benchmark::DoNotOptimize(angles.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_VectorFieldLarge, SST, npr::VECTOR_SST, false)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_VectorFieldLarge, SSTPyramid, npr::VECTOR_SST, true)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_VectorFieldLarge, ETF, npr::VECTOR_ETF, false)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_VectorFieldLarge, ETFPyramid, npr::VECTOR_ETF, true)->Apply(bench::sizeArgs);
+
+// recompute after a brush stroke of 32x32 pixels
+void BM_VectorFieldEstimatorUpdate(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    npr::VectorFieldEstimator estimator(5);
+    estimator.compute(gray);
+    const cv::Rect dirty(size / 2 - 16, size / 2 - 16, 32, 32);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(estimator.update(gray, dirty));
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_VectorFieldEstimatorUpdate)->Apply(bench::sizeArgs);
+
+void BM_DetectSingular(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    npr::TensorField sst;
+    npr::calcStructureTensor(gray, &sst, 11);
+    std::vector<npr::SingularPoint> points;
+    for (auto _ : state) {
+        npr::detectSingular(sst, &points);
+        benchmark::DoNotOptimize(points.data());
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_DetectSingular)->Apply(bench::sizeArgs);
+
+// ------------------------------------------------------------------
+// NPR filters
+// ------------------------------------------------------------------
+
+typedef void (*PdeFilter)(cv::InputArray, cv::OutputArray, double, int);
+typedef void (*MorphFilter)(cv::InputArray, cv::OutputArray, int);
+typedef void (*KuwaharaFilter)(cv::InputArray, cv::OutputArray, int, int);
+
+void BM_PdeFilter(benchmark::State& state, PdeFilter func) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& img = bench::colorImage(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        func(img, out, 0.05, 5);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_PdeFilter, AD, filter::solveAD)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_PdeFilter, SF, filter::solveSF)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_PdeFilter, MCF, filter::solveMCF)->Apply(bench::sizeArgs);
+
+void BM_Morphology(benchmark::State& state, MorphFilter func) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        func(gray, out, 3);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_Morphology, Erode, filter::morphErode)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Morphology, Dilate, filter::morphDilate)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Morphology, Open, filter::morphOpen)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Morphology, Close, filter::morphClose)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Morphology, Gradient, filter::morphGradient)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Morphology, Tophat, filter::morphTophat)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_Morphology, Blackhat, filter::morphBlackhat)->Apply(bench::sizeArgs);
+
+void BM_Kuwahara(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& img = bench::colorImage(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        filter::kuwaharaFilter(img, out, 5);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_Kuwahara)->Apply(bench::sizeArgs);
+
+void BM_KuwaharaVariant(benchmark::State& state, KuwaharaFilter func) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& img = bench::colorImage(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        func(img, out, 8, 7);
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_KuwaharaVariant, General, filter::generalKF)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_KuwaharaVariant, Anisotropic, filter::anisoKF)->Apply(bench::sizeArgs);
+
+void BM_TiledAnisoKF(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& img = bench::colorImage(size);
+    cv::Mat out;
+    for (auto _ : state) {
+        lime::tiledFilter(img, out, [](const cv::Mat& in, cv::OutputArray tileOut, const cv::Rect& region) {
+            filter::anisoKF(in, tileOut, 8, 7);
+        }, npr::halo::anisoKF(7));
+        benchmark::DoNotOptimize(out.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_TiledAnisoKF)->Apply(bench::sizeArgs);
+
+void BM_CalcTangent(benchmark::State& state, npr::ETFKernel kernel) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    cv::Mat tangent;
+    for (auto _ : state) {
+        filter::calcTangent(gray, tangent, 5, 3, kernel);
+        benchmark::DoNotOptimize(tangent.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_CalcTangent, Disk, npr::ETF_KERNEL_DISK)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_CalcTangent, Separable, npr::ETF_KERNEL_SEPARABLE)->Apply(bench::sizeArgs);
+
+// ------------------------------------------------------------------
+// Poisson disk sampling
+// ------------------------------------------------------------------
+
+void BM_PoissonDisk(benchmark::State& state, npr::PdsMethod method) {
+    const int size = static_cast<int>(state.range(0));
+    const cv::Mat& gray = bench::grayImage(size);
+    std::vector<cv::Point2f> samples;
+    for (auto _ : state) {
+        samples.clear();
+        npr::poissonDisk(gray, &samples, method, 2.0, 5.0);
+        benchmark::DoNotOptimize(samples.data());
+    }
+    state.counters["samples"] = static_cast<double>(samples.size());
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK_CAPTURE(BM_PoissonDisk, RandQueue, npr::PDS_RAND_QUEUE)->Apply(bench::sizeArgs);
+BENCHMARK_CAPTURE(BM_PoissonDisk, FastParallel, npr::PDS_FAST_PARALLEL)->Apply(bench::sizeArgs);
+
+// Neighbor query of Poisson disk sampling on dense points: per-cell vectors
+// with a fixed 5x5 neighborhood (former lime::Grid) vs. flat buckets with
+// a radius query.
+std::vector<cv::Point2f> densePoints(int size, double radius) {
+    std::vector<cv::Point2f> points;
+    for (double y = 0.0; y < size; y += radius) {
+        for (double x = 0.0; x < size; x += radius) {
+            points.push_back(cv::Point2f(static_cast<float>(x), static_cast<float>(y)));
+        }
+    }
+    return points;
+}
+
+void BM_GridQueryNested(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0)) / 8;
+    const double radius = 2.0;
+    const double cellSize = size / 15.0;
+    const int nCells = static_cast<int>(ceil(size / cellSize));
+    std::vector<cv::Point2f> points = densePoints(size, radius);
+    std::vector<std::vector<cv::Point2f> > cells(nCells * nCells);
+    for (size_t i = 0; i < points.size(); i++) {
+        cells[static_cast<int>(points[i].y / cellSize) * nCells + static_cast<int>(points[i].x / cellSize)]
+            .push_back(points[i]);
+    }
+
+    lime::Random rand(2015);
+    int64_t hits = 0;
+    for (auto _ : state) {
+        const cv::Point2f q(static_cast<float>(rand.randReal() * size), static_cast<float>(rand.randReal() * size));
+        bool found = false;
+        for (int dy = -2; dy <= 2 && !found; dy++) {
+            for (int dx = -2; dx <= 2 && !found; dx++) {
+                const int xx = static_cast<int>(q.x / cellSize + dx);
+                const int yy = static_cast<int>(q.y / cellSize + dy);
+                if (xx < 0 || yy < 0 || xx >= nCells || yy >= nCells) continue;
+                const std::vector<cv::Point2f>& v = cells[yy * nCells + xx];
+                for (size_t i = 0; i < v.size(); i++) {
+                    if (hypot(q.x - v[i].x, q.y - v[i].y) < 0.5 * radius) {
+                        found = true;
+                        break;
+                    }
+                }
+            }
+        }
+        hits += found ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GridQueryNested)->Apply(bench::sizeArgs);
+
+void BM_GridQueryFlat(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0)) / 8;
+    const double radius = 2.0;
+    const int nCells = static_cast<int>(ceil(size / radius));
+    std::vector<cv::Point2f> points = densePoints(size, radius);
+    lime::Grid<cv::Point2f> grid(nCells, nCells, radius);
+    for (size_t i = 0; i < points.size(); i++) {
+        grid.push(points[i]);
+    }
+
+    lime::Random rand(2015);
+    int64_t hits = 0;
+    for (auto _ : state) {
+        const cv::Point2f q(static_cast<float>(rand.randReal() * size), static_cast<float>(rand.randReal() * size));
+        hits += grid.containsWithin(q, 0.5 * radius) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GridQueryFlat)->Apply(bench::sizeArgs);
+
+// ------------------------------------------------------------------
+// Noise generation
+// ------------------------------------------------------------------
+
+void BM_RandomScalar(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    std::vector<float> buf(size * size);
+    lime::Random rand(2015);
+    for (auto _ : state) {
+        for (size_t i = 0; i < buf.size(); i++) {
+            buf[i] = static_cast<float>(rand.randReal());
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_RandomScalar)->Apply(bench::sizeArgs);
+
+void BM_RandomFill(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    std::vector<float> buf(size * size);
+    lime::Random rand(2015);
+    for (auto _ : state) {
+        rand.fill(buf.data(), static_cast<int>(buf.size()));
+        benchmark::DoNotOptimize(buf.data());
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_RandomFill)->Apply(bench::sizeArgs);
+
+// Box-Muller transform (former implementation of Random::randNorm) as a reference
+void BM_RandNormBoxMuller(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    std::vector<float> buf(size * size);
+    lime::Random rand(2015);
+    for (auto _ : state) {
+        for (size_t i = 0; i < buf.size(); i++) {
+            const double r1 = (static_cast<double>(rand.randUInt()) + 0.5) * (1.0 / 4294967296.0);
+            const double r2 = rand.randReal();
+            buf[i] = static_cast<float>(sqrt(-2.0 * log(r1)) * sin(2.0 * PI * r2));
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_RandNormBoxMuller)->Apply(bench::sizeArgs);
+
+void BM_RandNormZiggurat(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    std::vector<float> buf(size * size);
+    lime::Random rand(2015);
+    for (auto _ : state) {
+        for (size_t i = 0; i < buf.size(); i++) {
+            buf[i] = static_cast<float>(rand.randNorm());
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_RandNormZiggurat)->Apply(bench::sizeArgs);
+
+void BM_FillNormal(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    std::vector<float> buf(size * size);
+    lime::Random rand(2015);
+    for (auto _ : state) {
+        rand.fillNormal(buf.data(), static_cast<int>(buf.size()));
+        benchmark::DoNotOptimize(buf.data());
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_FillNormal)->Apply(bench::sizeArgs);
+
+void BM_NoiseRandom(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    cv::Mat noise;
+    for (auto _ : state) {
+        npr::noise::random(noise, cv::Size(size, size));
+        benchmark::DoNotOptimize(noise.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_NoiseRandom)->Apply(bench::sizeArgs);
+
+void BM_NoisePerlin(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    cv::Mat noise;
+    for (auto _ : state) {
+        npr::noise::perlin(noise, cv::Size(size, size), 4);
+        benchmark::DoNotOptimize(noise.data);
+    }
+    bench::setPixelsProcessed(state, size);
+}
+BENCHMARK(BM_NoisePerlin)->Apply(bench::sizeArgs);
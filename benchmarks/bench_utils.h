@@ -0,0 +1,104 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef BENCHMARKS_BENCH_UTILS_H_
+#define BENCHMARKS_BENCH_UTILS_H_
+
+#include <opencv2/opencv.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <algorithm>
+
+namespace bench {
+
+// * register the standard input sizes (512^2, 2K^2 and 8K^2) to a benchmark
+inline void sizeArgs(benchmark::internal::Benchmark* b) {
+    b->Arg(512)->Arg(2048)->Arg(8192)->Unit(benchmark::kMillisecond);
+}
+
+// * report the number of processed pixels so that throughput is comparable between sizes
+inline void setPixelsProcessed(benchmark::State& state, int size) {
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size) * size);
+}
+
+/* Synthetic grayscale image of CV_32FC1 format with values in [0, 1]. The pattern
+ * (rings, stripes and hashed noise) is scaled with the image size, so that
+ * every size has the same structure.
+ */
+inline const cv::Mat& grayImage(int size) {
+    static cv::Mat image;
+    if (image.rows != size) {
+        image = cv::Mat(size, size, CV_32FC1);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                double u = static_cast<double>(x) / size - 0.5;
+                double v = static_cast<double>(y) / size - 0.5;
+                unsigned int h = (x * 73856093U) ^ (y * 19349663U);
+                h = (h ^ (h >> 13)) * 1274126177U;
+                double noise = (h & 0xffff) / 65535.0 - 0.5;
+                double val = 0.5 + 0.25 * sin(60.0 * sqrt(u * u + v * v))
+                           + 0.15 * sin(40.0 * (u + v)) + 0.1 * noise;
+                image.at<float>(y, x) = static_cast<float>(std::max(0.0, std::min(val, 1.0)));
+            }
+        }
+    }
+    return image;
+}
+
+// * synthetic color image of CV_32FC3 format with values in [0, 1]
+inline const cv::Mat& colorImage(int size) {
+    static cv::Mat image;
+    if (image.rows != size) {
+        const cv::Mat& gray = grayImage(size);
+        image = cv::Mat(size, size, CV_32FC3);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                float g = gray.at<float>(y, x);
+                float t = static_cast<float>(x) / size;
+                image.at<float>(y, x * 3 + 0) = g;
+                image.at<float>(y, x * 3 + 1) = 0.5f * g + 0.5f * t;
+                image.at<float>(y, x * 3 + 2) = 1.0f - g;
+            }
+        }
+    }
+    return image;
+}
+
+// * synthetic vector field of CV_32FC2 format (vortex around the image center)
+inline const cv::Mat& vectorField(int size) {
+    static cv::Mat vfield;
+    if (vfield.rows != size) {
+        vfield = cv::Mat(size, size, CV_32FC2);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                double theta = atan2(x - size / 2.0, -(y - size / 2.0));
+                vfield.at<float>(y, x * 2 + 0) = static_cast<float>(cos(theta));
+                vfield.at<float>(y, x * 2 + 1) = static_cast<float>(sin(theta));
+            }
+        }
+    }
+    return vfield;
+}
+
+}  // namespace bench
+
+#endif  // BENCHMARKS_BENCH_UTILS_H_
@@ -166,22 +166,13 @@ void demo_img(const std::string& filename) {
     }
 
     img.convertTo(img, CV_32FC3, 1.0 / 255.0);
-    const int width  = img.cols;
-    const int height = img.rows;
-    const double EPS = 1.0e-10;
-
-    cv::Mat angles;
-
-    lime::npr::calcSST(img, sst, ksize);
-    lime::npr::calcVectorField(img, angles, ksize);
-    vfield = cv::Mat(height, width, CV_32FC2);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float theta = angles.at<float>(y, x);
-            vfield.at<float>(y, x * 2 + 0) = static_cast<float>(2.0 * cos(theta));
-            vfield.at<float>(y, x * 2 + 1) = static_cast<float>(2.0 * sin(theta));
-        }
-    }
+
+    lime::npr::TensorField field;
+    lime::npr::calcStructureTensor(img, &field, ksize);
+    sst = field.toMat();
+    lime::npr::calcVectorFieldPyramid(img, vfield, ksize, lime::npr::VECTOR_SST, lime::npr::EDGE_SOBEL,
+                                      -1, lime::npr::VFIELD_VECTORS);
+    vfield.convertTo(vfield, CV_32FC2, 2.0);
 
     cv::Mat noise;
     lime::npr::noise::random(noise, img.size());
@@ -209,10 +209,10 @@ void demoDOG(const cv::Mat& img) {
 }
 
 void demoCEF(const cv::Mat& img) {
-    cv::Mat vfield, tangent;
-    lime::npr::calcVectorField(img, vfield, 5,
-                               lime::npr::VECTOR_SST, lime::npr::EDGE_SOBEL);
-    lime::npr::angle2vector(vfield, tangent, 2.0);
+    cv::Mat tangent;
+    lime::npr::calcVectorField(img, tangent, 5, lime::npr::VECTOR_SST, lime::npr::EDGE_SOBEL,
+                               lime::npr::VFIELD_VECTORS);
+    tangent.convertTo(tangent, CV_32FC2, 2.0);
 
     cv::Mat tmp, out;
     cout << "[CEF] LIC Runge-Kutta -> ";
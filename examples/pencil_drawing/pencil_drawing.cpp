@@ -104,15 +104,17 @@ void LIConv(cv::OutputArray lic_, cv::InputArray img_, cv::InputArray etf_, cv::
     int totalStep = dim * height * width;
     int progress = 0;
 
-    lime::Random rand = lime::Random::getRNG();
+    // each pixel has its own random stream, so that the loop can run in parallel
+    const lime::Random base = lime::Random::getRNG().split();
 
     for (int y = 0; y < height; y++) {
-        ompfor (int x = 0; x < width; x++) {  // NOLINT
+        lime::parallel_for(0, width, [&](int x) {
             std::vector<double> s_sum(dim, 0.0);
             std::vector<double> w_sum(dim, 0.0);
             std::vector<double> sum(dim, 0.0);
             std::vector<double> weight(dim, 0.0);
 
+            lime::Random rand = base.stream(y * width + x);
             double t_i = tau / n * (rand.randInt(2*n+1) - n);
             for (int t = -t_disc; t <= t_disc; t++) {
                 double theta = tau / t_disc * t +  etf.at<float>(y, x);
@@ -141,7 +143,7 @@ void LIConv(cv::OutputArray lic_, cv::InputArray img_, cv::InputArray etf_, cv::
             for (int c = 0; c < dim; c++) {
                 lic.at<float>(y, x*dim+c) = static_cast<float>(1.0 - sum[c] / (ratio * weight[c]));
             }
-        }
+        });
 
         // Show progress bar
         progress += width * dim;
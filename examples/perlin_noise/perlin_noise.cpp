@@ -31,7 +31,7 @@ int main(int argc, char** argv) {
     const int height = 256;
     cv::Mat pnoise = cv::Mat::zeros(height, width, CV_32FC1);
 
-    lime::Random rand = lime::Random::getRNG();
+    lime::Random& rand = lime::Random::getRNG();
 
     for (int i = 0; i < 100; i++) {
         int scaleW = 8;
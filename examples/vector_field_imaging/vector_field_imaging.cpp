@@ -25,12 +25,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <cmath>
 #include <ctime>
 #include <iostream>
+#include <vector>
 
 #include "../../include/lime.hpp"
 
-void demo_circle() {
-    const int width  = 512;
-    const int height = 512;
+cv::Mat circle_field(int width, int height) {
     cv::Mat vfield = cv::Mat(height, width, CV_32FC2);
 
     const int cx = width / 2;
@@ -44,6 +43,13 @@ void demo_circle() {
             vfield.at<float>(y, x * 2 + 1) = static_cast<float>(2.0 * sin(theta));
         }
     }
+    return vfield;
+}
+
+void demo_circle() {
+    const int width  = 512;
+    const int height = 512;
+    cv::Mat vfield = circle_field(width, height);
 
     cv::Mat noise, classic, euler, runge;
     lime::npr::noise::random(noise, cv::Size(width, height));
@@ -73,16 +79,10 @@ void demo_img(const cv::Mat& img) {
     const int height = img.rows;
     img.convertTo(img, CV_32FC1, 1.0 / 255.0);
 
-    cv::Mat sst, vfield;
-    lime::npr::calcVectorField(img, sst, 11, lime::npr::VECTOR_SST, lime::npr::EDGE_SOBEL);
-    vfield = cv::Mat(height, width, CV_32FC2);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float theta = sst.at<float>(y, x);
-            vfield.at<float>(y, x * 2 + 0) = static_cast<float>(2.0 * cos(theta));
-            vfield.at<float>(y, x * 2 + 1) = static_cast<float>(2.0 * sin(theta));
-        }
-    }
+    cv::Mat vfield;
+    lime::npr::calcVectorField(img, vfield, 11, lime::npr::VECTOR_SST, lime::npr::EDGE_SOBEL,
+                               lime::npr::VFIELD_VECTORS);
+    vfield.convertTo(vfield, CV_32FC2, 2.0);
 
     cv::Mat noise, flow, out;
     lime::npr::noise::random(noise, cv::Size(width, height));
@@ -96,11 +96,37 @@ void demo_img(const cv::Mat& img) {
     cv::destroyAllWindows();
 }
 
+void demo_animation() {
+    const int width  = 512;
+    const int height = 512;
+    const int frames = 30;
+    lime::npr::StreamlineCache cache(circle_field(width, height), 20, lime::npr::LIC_EULARIAN);
+
+    cv::Mat noise;
+    lime::npr::noise::random(noise, cv::Size(width, height));
+
+    printf("[LIC] Animation   -> ");
+    std::vector<cv::Mat> video(frames);
+    lime::npr::licAnimation(noise, cache, frames, [&](int i, const cv::Mat& frame) {
+        frame.copyTo(video[i]);
+    });
+    printf("OK\n");
+
+    for (int loop = 0; loop < 5; loop++) {
+        for (int i = 0; i < frames; i++) {
+            cv::imshow("Animation", video[i]);
+            cv::waitKey(40);
+        }
+    }
+    cv::destroyAllWindows();
+}
+
 int main(int argc, char** argv) {
     if (argc > 1) {
         cv::Mat img = cv::imread(argv[1], cv::IMREAD_GRAYSCALE);
         demo_img(img);
     } else {
         demo_circle();
+        demo_animation();
     }
 }
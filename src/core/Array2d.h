@@ -22,35 +22,107 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_CORE_ARRAY2D_H_
 #define SRC_CORE_ARRAY2D_H_
 
+#include <opencv2/opencv.hpp>
+
 namespace lime {
 
+/* OpenCV type corresponding to the element type of Array2d. Specialize
+ * this for user-defined element types to enable Array2d::asMat/fromMat.
+ */
 template <class Ty>
-class Array2d {
- private:
-    int nrows, ncols;
-    Ty* data;
+struct MatTraits {
+    enum { type = cv::DataType<Ty>::type };
+};
 
+/* A view of a contiguous range of elements (such as a row of Array2d) */
+template <class Ty>
+class ArraySpan {
  public:
+    ArraySpan(Ty* ptr, int size) : ptr_(ptr), size_(size) {}
+
+    Ty& operator[](int i) const { return ptr_[i]; }
+    Ty* begin() const { return ptr_; }
+    Ty* end() const { return ptr_ + size_; }
+    Ty* data() const { return ptr_; }
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+ private:
+    Ty* ptr_;
+    int size_;
+};  // class ArraySpan
+
+/* 2D array whose first element (and every row, if padded) is aligned to
+ * 64-byte boundary. The array owns its elements, or is a view of the buffer
+ * of cv::Mat (see fromMat).
+ */
+template <class Ty>
+class Array2d {
+ public:
+    // * alignment in bytes of the storage
+    static const int ALIGNMENT = 64;
+
     Array2d();
 
+    /* Allocate memory space whose elements are value-initialized
+     * @param[in] rows: number of rows
+     * @param[in] cols: number of columns
+     */
     Array2d(int rows, int cols);
 
     /* Allocate memory space and fill it with the specified value
      * @param[in] rows: number of rows
      * @param[in] cols: number of columns
      * @param[in] value: a value with which the array is filled
+     * @param[in] padded: if true, each row starts at 64-byte boundary
      */
-    Array2d(int rows, int cols, const Ty& val);
+    Array2d(int rows, int cols, const Ty& val, bool padded = false);
 
     Array2d(const Array2d& ary);
 
+    Array2d(Array2d&& ary);
+
+    ~Array2d();
+
     Array2d& operator=(const Array2d& ary);
 
+    Array2d& operator=(Array2d&& ary);
+
+    // * element access (indices are checked in debug builds)
     Ty& operator()(int i, int j) const;
 
+    // * pointer to the first element of the i-th row
+    Ty* ptr(int i) const;
+
+    // * view of the i-th row
+    ArraySpan<Ty> row(int i) const;
+
     int cols() const;
 
     int rows() const;
+
+    // * number of elements between the beginnings of successive rows
+    int step() const;
+
+    /* Wrap the elements by cv::Mat without copying. The returned matrix
+     * refers the memory of this array, which must outlive the matrix.
+     */
+    cv::Mat asMat() const;
+
+    /* Create a view of the buffer of cv::Mat without copying. The view
+     * shares the reference count of "mat", so the buffer is kept alive
+     * while the view exists. Copies of the view are deep copies.
+     */
+    static Array2d fromMat(const cv::Mat& mat);
+
+ private:
+    void allocate(int rows, int cols, bool padded);
+    void release();
+
+    int nrows, ncols, nstep;
+    Ty* data;
+    void* storage;   // * memory owned by this array (null for views)
+    cv::Mat holder;  // * keeps the buffer of cv::Mat alive for views
 };  // class Array2d
 
 }  // namespace lime
@@ -22,7 +22,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_CORE_ARRAY2D_DETAIL_H_
 #define SRC_CORE_ARRAY2D_DETAIL_H_
 
-#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+#include <utility>
 
 #include "common.hpp"
 
@@ -32,57 +35,119 @@ template <class Ty>
 Array2d<Ty>::Array2d()
     : nrows(0)
     , ncols(0)
-    , data(0) {
+    , nstep(0)
+    , data(0)
+    , storage(0)
+    , holder() {
 }
 
 template <class Ty>
 Array2d<Ty>::Array2d(int rows, int cols)
-    : nrows(rows)
-    , ncols(cols)
-    , data(0) {
+    : nrows(0)
+    , ncols(0)
+    , nstep(0)
+    , data(0)
+    , storage(0)
+    , holder() {
     msg_assert(rows > 0 && cols > 0, "The array size must be positive.");
-    data = new Ty[rows * cols];
-    memset(data, 0, sizeof(Ty)* rows * cols);
+    allocate(rows, cols, false);
+    for (int i = 0; i < nrows; i++) {
+        Ty* p = ptr(i);
+        for (int j = 0; j < ncols; j++) new(p + j) Ty();
+    }
 }
 
 template <class Ty>
-Array2d<Ty>::Array2d(int rows, int cols, const Ty& value)
-    : nrows(rows)
-    , ncols(cols)
-    , data(0) {
+Array2d<Ty>::Array2d(int rows, int cols, const Ty& value, bool padded)
+    : nrows(0)
+    , ncols(0)
+    , nstep(0)
+    , data(0)
+    , storage(0)
+    , holder() {
     msg_assert(rows > 0 && cols > 0, "The array size must be positive.");
-    data = new Ty[rows * cols];
-
-    Ty *s = &data[0];
-    Ty *e = &data[rows * cols - 1];
-    for (Ty* p = s; p != e; ++p) *p = value;
+    allocate(rows, cols, padded);
+    for (int i = 0; i < nrows; i++) {
+        Ty* p = ptr(i);
+        for (int j = 0; j < ncols; j++) new(p + j) Ty(value);
+    }
 }
 
 template <class Ty>
 Array2d<Ty>::Array2d(const Array2d<Ty>& ary)
+    : nrows(0)
+    , ncols(0)
+    , nstep(0)
+    , data(0)
+    , storage(0)
+    , holder() {
+    if (ary.data == 0) return;
+
+    allocate(ary.nrows, ary.ncols, ary.nstep != ary.ncols);
+    for (int i = 0; i < nrows; i++) {
+        Ty* p = ptr(i);
+        const Ty* q = ary.ptr(i);
+        for (int j = 0; j < ncols; j++) new(p + j) Ty(q[j]);
+    }
+}
+
+template <class Ty>
+Array2d<Ty>::Array2d(Array2d<Ty>&& ary)
     : nrows(ary.nrows)
     , ncols(ary.ncols)
-    , data(0) {
-    data = new Ty[ary.nrows * ary.ncols];
-    memcpy(data, ary.data, sizeof(Ty)* ary.nrows * ary.ncols);
+    , nstep(ary.nstep)
+    , data(ary.data)
+    , storage(ary.storage)
+    , holder(ary.holder) {
+    ary.nrows = ary.ncols = ary.nstep = 0;
+    ary.data = 0;
+    ary.storage = 0;
+    ary.holder = cv::Mat();
 }
 
 template <class Ty>
-Array2d<Ty>& Array2d<Ty>::operator=(const Array2d<Ty>& ary) {
-    this->nrows = ary.nrows;
-    this->ncols = ary.ncols;
+Array2d<Ty>::~Array2d() {
+    release();
+}
 
-    delete[] data;
-    data = new Ty[ary.nrows * ary.ncols];
-    memcpy(data, ary.data, sizeof(Ty)* ary.nrows * ary.ncols);
+template <class Ty>
+Array2d<Ty>& Array2d<Ty>::operator=(const Array2d<Ty>& ary) {
+    if (this != &ary) {
+        Array2d<Ty> temp(ary);
+        *this = std::move(temp);
+    }
+    return *this;
+}
 
+template <class Ty>
+Array2d<Ty>& Array2d<Ty>::operator=(Array2d<Ty>&& ary) {
+    if (this != &ary) {
+        release();
+        std::swap(nrows, ary.nrows);
+        std::swap(ncols, ary.ncols);
+        std::swap(nstep, ary.nstep);
+        std::swap(data, ary.data);
+        std::swap(storage, ary.storage);
+        std::swap(holder, ary.holder);
+    }
     return *this;
 }
 
 template <class Ty>
 Ty& Array2d<Ty>::operator()(int i, int j) const {
     msg_assert(i >= 0 && j >= 0 && i < nrows && j < ncols, "Array index out of bounds");
-    return data[i * ncols + j];
+    return data[i * nstep + j];
+}
+
+template <class Ty>
+Ty* Array2d<Ty>::ptr(int i) const {
+    msg_assert(i >= 0 && i < nrows, "Row index out of bounds");
+    return data + i * nstep;
+}
+
+template <class Ty>
+ArraySpan<Ty> Array2d<Ty>::row(int i) const {
+    return ArraySpan<Ty>(ptr(i), ncols);
 }
 
 template <class Ty>
@@ -95,6 +160,66 @@ int Array2d<Ty>::cols() const {
     return ncols;
 }
 
+template <class Ty>
+int Array2d<Ty>::step() const {
+    return nstep;
+}
+
+template <class Ty>
+cv::Mat Array2d<Ty>::asMat() const {
+    if (data == 0) return cv::Mat();
+    return cv::Mat(nrows, ncols, MatTraits<Ty>::type, data, sizeof(Ty) * nstep);
+}
+
+template <class Ty>
+Array2d<Ty> Array2d<Ty>::fromMat(const cv::Mat& mat) {
+    Array2d<Ty> view;
+    if (mat.empty()) return view;
+
+    msg_assert(mat.dims == 2 && mat.type() == MatTraits<Ty>::type,
+               "The type of cv::Mat does not match the element type.");
+    msg_assert(mat.step[0] % sizeof(Ty) == 0, "The row step of cv::Mat must be a multiple of the element size.");
+
+    view.nrows = mat.rows;
+    view.ncols = mat.cols;
+    view.nstep = static_cast<int>(mat.step[0] / sizeof(Ty));
+    view.data = reinterpret_cast<Ty*>(mat.data);
+    view.holder = mat;
+    return view;
+}
+
+template <class Ty>
+void Array2d<Ty>::allocate(int rows, int cols, bool padded) {
+    int step = cols;
+    if (padded && ALIGNMENT % sizeof(Ty) == 0) {
+        const int perLine = ALIGNMENT / static_cast<int>(sizeof(Ty));
+        step = (cols + perLine - 1) / perLine * perLine;
+    }
+
+    storage = ::operator new(sizeof(Ty) * rows * step + ALIGNMENT);
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(storage);
+    const uintptr_t aligned = (addr + ALIGNMENT - 1) & ~static_cast<uintptr_t>(ALIGNMENT - 1);
+    data = reinterpret_cast<Ty*>(aligned);
+    nrows = rows;
+    ncols = cols;
+    nstep = step;
+}
+
+template <class Ty>
+void Array2d<Ty>::release() {
+    if (storage != 0) {
+        for (int i = 0; i < nrows; i++) {
+            Ty* p = data + i * nstep;
+            for (int j = 0; j < ncols; j++) p[j].~Ty();
+        }
+        ::operator delete(storage);
+    }
+    nrows = ncols = nstep = 0;
+    data = 0;
+    storage = 0;
+    holder.release();
+}
+
 }  // namespace lime
 
 #endif  // SRC_CORE_ARRAY2D_DETAIL_H_
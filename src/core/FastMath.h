@@ -0,0 +1,47 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_FASTMATH_H_
+#define SRC_CORE_FASTMATH_H_
+
+namespace lime {
+
+/* Polynomial approximations of trigonometric functions for floats. They have
+ * no branches except for selects, so that loops calling them are vectorized
+ * by the compiler. The absolute errors are below 4.0e-7 (i.e., about 1 ulp
+ * of the results) within the range [-2 pi, 2 pi] for fastSinCos.
+ */
+
+// * atan2(y, x), whose result is 0 for x = y = 0
+inline float fastAtan2(float y, float x);
+
+/* Sine and cosine of an angle
+ * @param[in] theta: angle in radian
+ * @param[out] s: sine of the angle
+ * @param[out] c: cosine of the angle
+ */
+inline void fastSinCos(float theta, float* s, float* c);
+
+}  // namespace lime
+
+#include "FastMath_detail.h"
+
+#endif  // SRC_CORE_FASTMATH_H_
@@ -0,0 +1,77 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_FASTMATH_DETAIL_H_
+#define SRC_CORE_FASTMATH_DETAIL_H_
+
+#include <cmath>
+#include <algorithm>
+
+namespace lime {
+
+inline float fastAtan2(float y, float x) {
+    const float ax = std::abs(x);
+    const float ay = std::abs(y);
+    const float mx = std::max(ax, ay);
+    const float mn = std::min(ax, ay);
+    const float a = mn / (mx > 0.0f ? mx : 1.0f);
+
+    // * minimax fit of atan(a) / a for a in [0, 1] as a polynomial of a^2
+    const float t = a * a;
+    float p = -4.052699078e-03f;
+    p = p * t + 2.185595967e-02f;
+    p = p * t - 5.590184405e-02f;
+    p = p * t + 9.641397744e-02f;
+    p = p * t - 1.390830278e-01f;
+    p = p * t + 1.994649768e-01f;
+    p = p * t - 3.332985342e-01f;
+    p = p * t + 9.999993443e-01f;
+    float r = a * p;
+
+    r = ay > ax ? 1.57079637f - r : r;
+    r = x < 0.0f ? 3.14159274f - r : r;
+    return y < 0.0f ? -r : r;
+}
+
+inline void fastSinCos(float theta, float* s, float* c) {
+    // * reduce to [-pi/4, pi/4] by the nearest multiple of pi/2, which is subtracted in three parts
+    const float u = theta * 0.636619772f;
+    const int k = static_cast<int>(u < 0.0f ? u - 0.5f : u + 0.5f);
+    const float fk = static_cast<float>(k);
+    const float r = ((theta - fk * 1.5703125f) - fk * 4.837512969970703125e-4f) - fk * 7.54978995489188216e-8f;
+
+    // * polynomials of Cephes library
+    const float r2 = r * r;
+    const float ps = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    const float pc = 1.0f - 0.5f * r2 +
+                     r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    // * rotate by the quadrant
+    const int q = k & 3;
+    const float sa = (q & 1) ? pc : ps;
+    const float ca = (q & 1) ? ps : pc;
+    *s = (q & 2) ? -sa : sa;
+    *c = ((q + 1) & 2) ? -ca : ca;
+}
+
+}  // namespace lime
+
+#endif  // SRC_CORE_FASTMATH_DETAIL_H_
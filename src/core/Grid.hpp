@@ -22,60 +22,73 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_CORE_GRID_HPP_
 #define SRC_CORE_GRID_HPP_
 
+#include <cmath>
 #include <vector>
 #include <algorithm>
 
+#include "common.hpp"
+#include "Array2d.h"
+
 namespace lime {
 
+/* Uniform grid of buckets. Items of all the cells are stored in a single
+ * array, where each cell owns a slot of its own capacity. A cell which
+ * overflows moves to a slot of twice the capacity at the end of the array,
+ * so that the memory is proportional to the number of the items even if
+ * they gather in a few cells. Cell (i, j) covers the region
+ * [j * cellSize, (j + 1) * cellSize) x [i * cellSize, (i + 1) * cellSize).
+ * T must be default constructible.
+ */
 template <class T>
 class Grid {
  private:
     int nrows;
     int ncols;
-    std::vector<std::vector<T> > data;
+    int initialCapacity;
+    double cellSize;
+    std::vector<T> items;
+    std::vector<size_t> offsets;
+    std::vector<int> counts;
+    std::vector<int> capacities;
 
  public:
     // * default constructor
-     Grid()
-         : nrows(0)
-         , ncols(0)
-         , data() {
-     }
-
-    // * constructor
-    Grid(int rows, int cols)
-        : nrows(rows)
-        , ncols(cols)
-        , data(rows * cols, std::vector<T>()) {
-        msg_assert(rows > 0 && cols > 0, "Size must be positive");
+    Grid()
+        : nrows(0)
+        , ncols(0)
+        , initialCapacity(4)
+        , cellSize(1.0)
+        , items()
+        , offsets()
+        , counts()
+        , capacities() {
     }
 
-    // * destructor
-    virtual ~Grid() {}
-
-    // * copy constructor
-    Grid(const Grid& grid)
-        : nrows(grid.nrows)
-        , ncols(grid.ncols)
-        , data(grid.nrows * grid.ncols, std::vector<T>()) {
-        dataCopy(grid);
+    /* constructor
+     * @param[in] rows: number of rows
+     * @param[in] cols: number of columns
+     * @param[in] size: side length of a cell (used by spatial queries)
+     * @param[in] cap: initial capacity of each cell
+     */
+    Grid(int rows, int cols, double size = 1.0, int cap = 4)
+        : nrows(0)
+        , ncols(0)
+        , initialCapacity(cap)
+        , cellSize(size)
+        , items()
+        , offsets()
+        , counts()
+        , capacities() {
+        msg_assert(size > 0.0 && cap > 0, "Cell size and capacity must be positive");
+        reset(rows, cols, cap);
     }
 
-    // * operator =
-    Grid& operator=(const Grid& grid) {
-        this->nrows = grid.nrows;
-        this->ncols = grid.ncols;
-        this->data = std::vector<std::vector<T> >(this->nrows * this->ncols, std::vector<T>());
-        dataCopy(grid);
-        return *this;
-    }
+    // * destructor
+    virtual ~Grid() {}
 
-    // Resize grid
+    // Resize grid (all the items are removed)
     void resize(int rows, int cols) {
-        msg_assert(rows > 0 && cols > 0, "Size must be positive");
-        this->nrows = rows;
-        this->ncols = cols;
-        data.resize(rows * cols);
+        reset(rows, cols, initialCapacity);
     }
 
     // * get number of rows
@@ -88,40 +101,109 @@ class Grid {
         return this->ncols;
     }
 
+    // * side length of a cell
+    double size() const {
+        return this->cellSize;
+    }
+
     // * check (i, j) is in the grid range
     bool hasCell(int i, int j) const {
         return i >= 0 && j >= 0 && i < nrows && j < ncols;
     }
 
     // * push at (i, j)
-    void pushAt(int i, int j, T t) {
-        data[i * ncols + j].push_back(t);
+    void pushAt(int i, int j, const T& t) {
+        msg_assert(hasCell(i, j), "Index out of bounds");
+        const size_t cell = static_cast<size_t>(i) * ncols + j;
+        if (counts[cell] == capacities[cell]) {
+            grow(cell);
+        }
+        items[offsets[cell] + counts[cell]] = t;
+        counts[cell]++;
     }
 
-    // * access vector of (i, j)
-    const std::vector<T>& operator()(int i, int j) const {
+    // * push an item with members x and y to the cell containing it
+    void push(const T& t) {
+        pushAt(static_cast<int>(t.y / cellSize), static_cast<int>(t.x / cellSize), t);
+    }
+
+    // * access items of (i, j)
+    ArraySpan<const T> operator()(int i, int j) const {
         msg_assert(i >= 0 && j >= 0 && i < nrows && j < ncols,
                    "Index out of bounds");
-        return data[i * ncols + j];
+        const size_t cell = static_cast<size_t>(i) * ncols + j;
+        return ArraySpan<const T>(items.data() + offsets[cell], counts[cell]);
     }
 
     // * size of vector at (i, j)
-    size_t sizeAt(int i, int j) {
-        return data[i*ncols + j].size();
+    size_t sizeAt(int i, int j) const {
+        return counts[static_cast<size_t>(i) * ncols + j];
     }
 
- private:
-    // * private method to copy grid data
-    void dataCopy(const Grid& grid) {
-        for (int y = 0; y < this->nrows; y++) {
-            for (int x = 0; x < this->ncols; x++) {
-                int index = y*this->ncols + x;
-                const std::vector<T>& p_src = grid.data[index];
-                std::vector<T>& p_dst = data[index];
-                p_dst.resize(p_src.size());
-                std::copy(p_src.begin(), p_src.end(), p_dst.begin());
+    /* Visit the items (which have members x and y) within the distance
+     * "radius" from "center". Only the cells overlapping the bounding box
+     * of the circle are scanned.
+     * @param[in] center: center of the query (any type with members x and y)
+     * @param[in] radius: radius of the query
+     * @param[in] func: function called as func(item). If it returns false, the query stops.
+     * @return false if the query is stopped by "func"
+     */
+    template <class P, class Func>
+    bool forEachWithin(const P& center, double radius, const Func& func) const {
+        const double cx = center.x;
+        const double cy = center.y;
+        const int x0 = std::max(0, static_cast<int>(floor((cx - radius) / cellSize)));
+        const int y0 = std::max(0, static_cast<int>(floor((cy - radius) / cellSize)));
+        const int x1 = std::min(ncols - 1, static_cast<int>(floor((cx + radius) / cellSize)));
+        const int y1 = std::min(nrows - 1, static_cast<int>(floor((cy + radius) / cellSize)));
+        const double r2 = radius * radius;
+        for (int i = y0; i <= y1; i++) {
+            for (int j = x0; j <= x1; j++) {
+                const size_t cell = static_cast<size_t>(i) * ncols + j;
+                const T* p = items.data() + offsets[cell];
+                for (int k = 0; k < counts[cell]; k++) {
+                    const double dx = p[k].x - cx;
+                    const double dy = p[k].y - cy;
+                    if (dx * dx + dy * dy < r2 && !func(p[k])) {
+                        return false;
+                    }
+                }
             }
         }
+        return true;
+    }
+
+    // * check if any item lies within the distance "radius" from "center"
+    template <class P>
+    bool containsWithin(const P& center, double radius) const {
+        return !forEachWithin(center, radius, [](const T&) { return false; });
+    }
+
+ private:
+    // * allocate empty cells
+    void reset(int rows, int cols, int cap) {
+        msg_assert(rows > 0 && cols > 0, "Size must be positive");
+        this->nrows = rows;
+        this->ncols = cols;
+        const size_t nCells = static_cast<size_t>(rows) * cols;
+        items.assign(nCells * cap, T());
+        offsets.resize(nCells);
+        for (size_t cell = 0; cell < nCells; cell++) {
+            offsets[cell] = cell * cap;
+        }
+        counts.assign(nCells, 0);
+        capacities.assign(nCells, cap);
+    }
+
+    // * move the cell to a new slot of twice the capacity at the end of the items
+    void grow(size_t cell) {
+        const size_t newOffset = items.size();
+        const int newCapacity = capacities[cell] * 2;
+        items.resize(newOffset + newCapacity, T());
+        std::copy(items.begin() + offsets[cell], items.begin() + offsets[cell] + counts[cell],
+                  items.begin() + newOffset);
+        offsets[cell] = newOffset;
+        capacities[cell] = newCapacity;
     }
 };  // class Grid
 
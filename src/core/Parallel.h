@@ -0,0 +1,141 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_PARALLEL_H_
+#define SRC_CORE_PARALLEL_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#include "Profile.h"
+
+namespace lime {
+
+/*
+ * A singleton pool of persistent worker threads. Each thread owns a queue of
+ * index ranges and idle threads steal ranges from the other queues, so that
+ * loops whose iterations have different costs are balanced dynamically.
+ */
+class ThreadPool {
+ public:
+    static ThreadPool& getPool();
+
+    /* Set the number of threads used for parallel loops (including the calling thread)
+     * @param[in] n: number of threads (non-positive value resets to the number of hardware threads)
+     */
+    void setNumThreads(int n);
+
+    int numThreads() const;
+
+    /* Execute task(b, e) for the sub-ranges of [begin, end)
+     * The first exception thrown by the task is rethrown on the calling thread after
+     * all the workers have left the loop; the chunks not yet started are skipped.
+     * @param[in] begin: first index
+     * @param[in] end: last index (exclusive)
+     * @param[in] grain: number of indices processed by a single task
+     * @param[in] task: function processing the range [b, e)
+     */
+    void run(int begin, int end, int grain, const std::function<void(int, int)>& task);
+
+    // * check whether the current thread is executing a parallel task
+    static bool inParallelRegion();
+
+ private:
+    struct Job {
+        const std::function<void(int, int)>* task;
+        std::atomic<int> remaining;
+        std::atomic<bool> failed;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+#ifdef LIME_ENABLE_PROFILE
+        profile::Scope* scope;
+#endif
+    };
+
+    struct Chunk {
+        int begin, end;
+        Job* job;
+    };
+
+    struct WorkQueue {
+        std::mutex mtx;
+        std::deque<Chunk> chunks;
+    };
+
+    ThreadPool();
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void startWorkers(int n);
+    void stopWorkers();
+    void workerLoop(int id);
+    bool popChunk(int id, Chunk* chunk);
+    void execute(const Chunk& chunk);
+    static bool& parallelFlag();
+
+    int nThreads;
+    std::vector<std::thread> workers;
+    std::vector<WorkQueue*> queues;
+
+    std::mutex runMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCond;
+    std::condition_variable doneCond;
+    unsigned int generation;
+    bool stopping;
+};  // class ThreadPool
+
+// * set number of threads used by lime::parallel_for
+inline void setNumThreads(int n);
+
+// * get number of threads used by lime::parallel_for
+inline int getNumThreads();
+
+/* Execute func(i) for every i in [begin, end) in parallel
+ * @param[in] begin: first index
+ * @param[in] end: last index (exclusive)
+ * @param[in] func: loop body which takes an index
+ * @param[in] grain: number of indices processed by a single task (0 for automatic)
+ */
+template <class Func>
+inline void parallel_for(int begin, int end, const Func& func, int grain = 0);
+
+/* Execute func(y, x) for every pixel of a rows x cols domain in parallel
+ * @param[in] rows: number of rows
+ * @param[in] cols: number of columns
+ * @param[in] func: loop body which takes a row index and a column index
+ * @param[in] grain: number of pixels processed by a single task (0 for automatic)
+ */
+template <class Func>
+inline void parallel_for_2d(int rows, int cols, const Func& func, int grain = 0);
+
+}  // namespace lime
+
+#include "Parallel_detail.h"
+
+#endif  // SRC_CORE_PARALLEL_H_
@@ -0,0 +1,303 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_PARALLEL_DETAIL_H_
+#define SRC_CORE_PARALLEL_DETAIL_H_
+
+#include <cstdint>
+#include <algorithm>
+
+#include "common.hpp"
+
+namespace lime {
+
+inline ThreadPool& ThreadPool::getPool() {
+    static ThreadPool instance;
+    return instance;
+}
+
+inline ThreadPool::ThreadPool()
+    : nThreads(1)
+    , workers()
+    , queues()
+    , generation(0)
+    , stopping(false) {
+    startWorkers(0);
+}
+
+inline ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+inline void ThreadPool::setNumThreads(int n) {
+    std::lock_guard<std::mutex> lock(runMutex);
+    stopWorkers();
+    startWorkers(n);
+}
+
+inline int ThreadPool::numThreads() const {
+    return nThreads;
+}
+
+inline bool ThreadPool::inParallelRegion() {
+    return parallelFlag();
+}
+
+inline bool& ThreadPool::parallelFlag() {
+    static thread_local bool flag = false;
+    return flag;
+}
+
+namespace {  // NOLINT
+
+// * marks the current thread as running a parallel task while in scope
+class ParallelRegionGuard {  // NOLINT
+ public:
+    explicit ParallelRegionGuard(bool* flag)
+        : flag(flag) {
+        *flag = true;
+    }
+
+    ~ParallelRegionGuard() {
+        *flag = false;
+    }
+
+ private:
+    ParallelRegionGuard(const ParallelRegionGuard&);
+    ParallelRegionGuard& operator=(const ParallelRegionGuard&);
+
+    bool* flag;
+};
+
+}  // unnamed namespace
+
+inline void ThreadPool::startWorkers(int n) {
+    nThreads = n > 0 ? n : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    stopping = false;
+    for (int i = 0; i < nThreads; i++) {
+        queues.push_back(new WorkQueue());
+    }
+
+    // the thread calling run() works as the 0th thread
+    for (int i = 1; i < nThreads; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+inline void ThreadPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCond.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    workers.clear();
+
+    for (size_t i = 0; i < queues.size(); i++) {
+        delete queues[i];
+    }
+    queues.clear();
+}
+
+inline void ThreadPool::run(int begin, int end, int grain, const std::function<void(int, int)>& task) {
+    if (begin >= end) return;
+
+    // nested loops and loops issued while the pool is busy run serially
+    if (nThreads == 1 || parallelFlag() || !runMutex.try_lock()) {
+        task(begin, end);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(runMutex, std::adopt_lock);
+
+    const int total = end - begin;
+    grain = std::max(grain, 1);
+    const int nChunks = (total + grain - 1) / grain;
+
+    Job job;
+    job.task = &task;
+    job.remaining = nChunks;
+    job.failed = false;
+#ifdef LIME_ENABLE_PROFILE
+    job.scope = profile::Scope::current();
+#endif
+
+    // contiguous blocks of chunks are assigned to each queue for locality
+    for (int q = 0; q < nThreads; q++) {
+        const int cBegin = static_cast<int>(static_cast<int64_t>(nChunks) * q / nThreads);
+        const int cEnd   = static_cast<int>(static_cast<int64_t>(nChunks) * (q + 1) / nThreads);
+        std::lock_guard<std::mutex> qlock(queues[q]->mtx);
+        for (int c = cBegin; c < cEnd; c++) {
+            Chunk chunk;
+            chunk.begin = begin + c * grain;
+            chunk.end   = std::min(chunk.begin + grain, end);
+            chunk.job   = &job;
+            queues[q]->chunks.push_back(chunk);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> wlock(wakeMutex);
+        generation++;
+    }
+    wakeCond.notify_all();
+
+    {
+        ParallelRegionGuard guard(&parallelFlag());
+        Chunk chunk;
+        while (popChunk(0, &chunk)) {
+            execute(chunk);
+        }
+    }
+
+    // the job lives on this stack frame, so wait for the workers even if the task failed
+    {
+        std::unique_lock<std::mutex> wlock(wakeMutex);
+        while (job.remaining.load() != 0) {
+            doneCond.wait(wlock);
+        }
+    }
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+inline void ThreadPool::workerLoop(int id) {
+    parallelFlag() = true;
+    unsigned int seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            while (!stopping && seen == generation) {
+                wakeCond.wait(lock);
+            }
+            if (stopping) return;
+            seen = generation;
+        }
+
+        Chunk chunk;
+        while (popChunk(id, &chunk)) {
+            execute(chunk);
+        }
+    }
+}
+
+inline bool ThreadPool::popChunk(int id, Chunk* chunk) {
+    // take from the front of the own queue
+    {
+        WorkQueue* own = queues[id];
+        std::lock_guard<std::mutex> lock(own->mtx);
+        if (!own->chunks.empty()) {
+            *chunk = own->chunks.front();
+            own->chunks.pop_front();
+            return true;
+        }
+    }
+
+    // steal from the back of the other queues
+    for (int k = 1; k < nThreads; k++) {
+        WorkQueue* victim = queues[(id + k) % nThreads];
+        std::lock_guard<std::mutex> lock(victim->mtx);
+        if (!victim->chunks.empty()) {
+            *chunk = victim->chunks.back();
+            victim->chunks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void ThreadPool::execute(const Chunk& chunk) {
+    // remaining chunks of a failed job are only counted down
+    if (!chunk.job->failed.load()) {
+        try {
+#ifdef LIME_ENABLE_PROFILE
+            // counters in the task are attached to the scope which issued the loop
+            profile::Scope::Binding binding(chunk.job->scope);
+#endif
+            (*chunk.job->task)(chunk.begin, chunk.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(chunk.job->errorMutex);
+            if (!chunk.job->error) {
+                chunk.job->error = std::current_exception();
+            }
+            chunk.job->failed = true;
+        }
+    }
+    if (chunk.job->remaining.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        doneCond.notify_all();
+    }
+}
+
+inline void setNumThreads(int n) {
+    ThreadPool::getPool().setNumThreads(n);
+}
+
+inline int getNumThreads() {
+    return ThreadPool::getPool().numThreads();
+}
+
+template <class Func>
+void parallel_for(int begin, int end, const Func& func, int grain) {
+    if (begin >= end) return;
+
+    ThreadPool& pool = ThreadPool::getPool();
+    if (grain <= 0) {
+        grain = std::max(1, (end - begin) / (pool.numThreads() * 8));
+    }
+
+    pool.run(begin, end, grain, [&func](int b, int e) {
+        for (int i = b; i < e; i++) {
+            func(i);
+        }
+    });
+}
+
+template <class Func>
+void parallel_for_2d(int rows, int cols, const Func& func, int grain) {
+    if (rows <= 0 || cols <= 0) return;
+
+    ThreadPool& pool = ThreadPool::getPool();
+    const int total = rows * cols;
+    if (grain <= 0) {
+        grain = std::max(cols, total / (pool.numThreads() * 8));
+    }
+
+    pool.run(0, total, grain, [&func, cols](int b, int e) {
+        int y = b / cols;
+        int x = b % cols;
+        for (int i = b; i < e; i++) {
+            func(y, x);
+            if (++x == cols) {
+                x = 0;
+                y++;
+            }
+        }
+    });
+}
+
+}  // namespace lime
+
+#endif  // SRC_CORE_PARALLEL_DETAIL_H_
@@ -0,0 +1,178 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_PROFILE_H_
+#define SRC_CORE_PROFILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <mutex>
+#include <chrono>
+
+/*
+ * Profiling macros. They compile to nothing unless LIME_ENABLE_PROFILE is
+ * defined before including lime, so that release builds pay no cost.
+ *   LIME_PROFILE_SCOPE(name): measure the time until the end of the current block
+ *   LIME_PROFILE_COUNT(name, value): add a value to a counter of the innermost scope
+ */
+#ifdef LIME_ENABLE_PROFILE
+#define LIME_PROFILE_CONCAT_(a, b) a ## b
+#define LIME_PROFILE_CONCAT(a, b) LIME_PROFILE_CONCAT_(a, b)
+#define LIME_PROFILE_SCOPE(NAME) \
+    lime::profile::Scope LIME_PROFILE_CONCAT(limeProfileScope, __LINE__)(NAME)
+#define LIME_PROFILE_COUNT(NAME, VALUE) \
+    lime::profile::count(NAME, static_cast<int64_t>(VALUE))
+#else  // LIME_ENABLE_PROFILE
+#define LIME_PROFILE_SCOPE(NAME) do {} while (false)
+#define LIME_PROFILE_COUNT(NAME, VALUE) do { (void)sizeof(VALUE); } while (false)
+#endif  // LIME_ENABLE_PROFILE
+
+namespace lime {
+
+namespace profile {
+
+// * a counter attached to a profiled scope
+typedef std::pair<const char*, int64_t> Counter;
+
+// * a record of a finished scope
+struct Event {
+    const char* name;
+    int tid;
+    int64_t start;     // microseconds from the profiler creation
+    int64_t duration;  // microseconds
+    std::vector<Counter> counters;
+};
+
+/*
+ * A singleton which collects the records of profiled scopes from all the
+ * threads. Names must be string literals (or live as long as the profiler).
+ */
+class Profiler {
+ public:
+    static Profiler& getProfiler();
+
+    // * enable or disable recording at run time (enabled by default)
+    void setEnabled(bool enabled);
+
+    bool isEnabled() const;
+
+    // * remove all the recorded events and counters
+    void clear();
+
+    // * append a record of a finished scope
+    void record(const Event& ev);
+
+    // * add a value to a counter which is not attached to any scope
+    void addCounter(const char* name, int64_t value);
+
+    // * microseconds from the profiler creation
+    int64_t now() const;
+
+    std::vector<Event> events() const;
+
+    /* Write the recorded events in Chrome trace format (JSON)
+     * which can be loaded by chrome://tracing
+     * @param[in] filename: output file name
+     */
+    void writeTrace(const std::string& filename) const;
+
+    /* Print the total time, the number of calls and the counters for each scope name
+     * @param[out] os: output stream
+     */
+    void report(std::ostream* os = &std::cout) const;
+
+ private:
+    Profiler();
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+
+    std::chrono::steady_clock::time_point epoch;
+    bool enabled;
+    mutable std::mutex mtx;
+    std::vector<Event> records;
+    std::vector<Counter> counters;
+};  // class Profiler
+
+/*
+ * RAII object which records the time between its construction and destruction.
+ * Scopes on the same thread are nested, and counters are attached to the innermost one.
+ * Tasks of lime::parallel_for are bound to the scope which issued the loop.
+ */
+class Scope {
+ public:
+    explicit Scope(const char* name);
+    ~Scope();
+
+    // * add a value to a counter of this scope (thread safe)
+    void addCounter(const char* name, int64_t value);
+
+    // * innermost open scope of the current thread (NULL if there is none)
+    static Scope* current();
+
+    // * RAII object which makes a scope of another thread the innermost one of the current thread
+    class Binding {
+     public:
+        explicit Binding(Scope* scope);
+        ~Binding();
+
+     private:
+        Binding(const Binding&);
+        Binding& operator=(const Binding&);
+
+        Scope* saved;
+    };
+
+ private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+
+    static Scope*& currentRef();
+
+    const char* name;
+    Scope* parent;
+    int64_t start;
+    bool active;
+    std::mutex mtx;
+    std::vector<Counter> counters;
+};  // class Scope
+
+/* Add a value to a counter of the innermost scope of the current thread. When the
+ * thread has no open scope (e.g. a worker of parallel_for), the value is added to
+ * the global counters of the profiler.
+ */
+inline void count(const char* name, int64_t value);
+
+// * write the recorded events in Chrome trace format
+inline void writeTrace(const std::string& filename);
+
+// * print the summary of the recorded events
+inline void report(std::ostream* os = &std::cout);
+
+}  // namespace profile
+
+}  // namespace lime
+
+#include "Profile_detail.h"
+
+#endif  // SRC_CORE_PROFILE_H_
@@ -0,0 +1,275 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_PROFILE_DETAIL_H_
+#define SRC_CORE_PROFILE_DETAIL_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <atomic>
+
+#include "common.hpp"
+
+namespace lime {
+
+namespace profile {
+
+namespace {  // NOLINT
+
+int threadIndex() {
+    static std::atomic<int> nThreads(0);
+    static thread_local int index = nThreads++;
+    return index;
+}
+
+std::string escapeJson(const char* str) {
+    std::string ret;
+    for (const char* p = str; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') ret += '\\';
+        ret += *p;
+    }
+    return ret;
+}
+
+}  // unnamed namespace
+
+#pragma region Profiler
+
+inline Profiler& Profiler::getProfiler() {
+    static Profiler instance;
+    return instance;
+}
+
+inline Profiler::Profiler()
+    : epoch(std::chrono::steady_clock::now())
+    , enabled(true)
+    , mtx()
+    , records()
+    , counters() {
+}
+
+inline void Profiler::setEnabled(bool enabled_) {
+    std::lock_guard<std::mutex> lock(mtx);
+    enabled = enabled_;
+}
+
+inline bool Profiler::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return enabled;
+}
+
+inline void Profiler::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    records.clear();
+    counters.clear();
+}
+
+inline void Profiler::record(const Event& ev) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (enabled) {
+        records.push_back(ev);
+    }
+}
+
+inline void Profiler::addCounter(const char* name, int64_t value) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!enabled) return;
+
+    for (size_t i = 0; i < counters.size(); i++) {
+        if (std::string(counters[i].first) == name) {
+            counters[i].second += value;
+            return;
+        }
+    }
+    counters.push_back(Counter(name, value));
+}
+
+inline int64_t Profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+inline std::vector<Event> Profiler::events() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return records;
+}
+
+inline void Profiler::writeTrace(const std::string& filename) const {
+    std::ofstream ofs(filename.c_str(), std::ios::out);
+    msg_assert(ofs.is_open(), "Failed to open the trace file: " << filename);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    ofs << "{\"traceEvents\":[";
+    for (size_t i = 0; i < records.size(); i++) {
+        const Event& ev = records[i];
+        ofs << (i == 0 ? "\n" : ",\n");
+        ofs << "{\"name\":\"" << escapeJson(ev.name) << "\",\"cat\":\"lime\",\"ph\":\"X\""
+            << ",\"pid\":0,\"tid\":" << ev.tid
+            << ",\"ts\":" << ev.start << ",\"dur\":" << ev.duration
+            << ",\"args\":{";
+        for (size_t k = 0; k < ev.counters.size(); k++) {
+            if (k != 0) ofs << ",";
+            ofs << "\"" << escapeJson(ev.counters[k].first) << "\":" << ev.counters[k].second;
+        }
+        ofs << "}}";
+    }
+
+    // counters which are not attached to any scope
+    for (size_t i = 0; i < counters.size(); i++) {
+        ofs << (records.empty() && i == 0 ? "\n" : ",\n");
+        ofs << "{\"name\":\"" << escapeJson(counters[i].first) << "\",\"cat\":\"lime\",\"ph\":\"C\""
+            << ",\"pid\":0,\"tid\":0,\"ts\":" << now()
+            << ",\"args\":{\"value\":" << counters[i].second << "}}";
+    }
+    ofs << "\n]}\n";
+}
+
+inline void Profiler::report(std::ostream* os) const {
+    struct Summary {
+        int64_t calls;
+        int64_t total;
+        std::map<std::string, int64_t> counters;
+        Summary() : calls(0), total(0), counters() {}
+    };
+
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<std::string> order;
+    std::map<std::string, Summary> summary;
+    for (size_t i = 0; i < records.size(); i++) {
+        const Event& ev = records[i];
+        if (summary.find(ev.name) == summary.end()) {
+            order.push_back(ev.name);
+        }
+
+        Summary& s = summary[ev.name];
+        s.calls += 1;
+        s.total += ev.duration;
+        for (size_t k = 0; k < ev.counters.size(); k++) {
+            s.counters[ev.counters[k].first] += ev.counters[k].second;
+        }
+    }
+
+    *os << std::left << std::setw(32) << "scope" << std::right
+       << std::setw(8) << "calls" << std::setw(14) << "total [ms]" << std::setw(14) << "mean [ms]" << std::endl;
+    for (size_t i = 0; i < order.size(); i++) {
+        const Summary& s = summary[order[i]];
+        *os << std::left << std::setw(32) << order[i] << std::right
+           << std::setw(8) << s.calls
+           << std::setw(14) << std::fixed << std::setprecision(3) << s.total * 1.0e-3
+           << std::setw(14) << s.total * 1.0e-3 / s.calls << std::endl;
+        std::map<std::string, int64_t>::const_iterator it;
+        for (it = s.counters.begin(); it != s.counters.end(); ++it) {
+            *os << "    " << it->first << ": " << it->second << std::endl;
+        }
+    }
+
+    for (size_t i = 0; i < counters.size(); i++) {
+        *os << counters[i].first << ": " << counters[i].second << std::endl;
+    }
+}
+
+#pragma endregion
+
+#pragma region Scope
+
+inline Scope::Scope(const char* name_)
+    : name(name_)
+    , parent(currentRef())
+    , start(0)
+    , active(Profiler::getProfiler().isEnabled())
+    , mtx()
+    , counters() {
+    currentRef() = this;
+    if (active) {
+        start = Profiler::getProfiler().now();
+    }
+}
+
+inline Scope::~Scope() {
+    currentRef() = parent;
+    if (active) {
+        Profiler& profiler = Profiler::getProfiler();
+        Event ev;
+        ev.name = name;
+        ev.tid = threadIndex();
+        ev.start = start;
+        ev.duration = profiler.now() - start;
+        ev.counters = counters;
+        profiler.record(ev);
+    }
+}
+
+inline void Scope::addCounter(const char* name_, int64_t value) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (size_t i = 0; i < counters.size(); i++) {
+        if (std::string(counters[i].first) == name_) {
+            counters[i].second += value;
+            return;
+        }
+    }
+    counters.push_back(Counter(name_, value));
+}
+
+inline Scope* Scope::current() {
+    return currentRef();
+}
+
+inline Scope*& Scope::currentRef() {
+    static thread_local Scope* scope = NULL;
+    return scope;
+}
+
+inline Scope::Binding::Binding(Scope* scope)
+    : saved(currentRef()) {
+    currentRef() = scope;
+}
+
+inline Scope::Binding::~Binding() {
+    currentRef() = saved;
+}
+
+#pragma endregion
+
+inline void count(const char* name, int64_t value) {
+    Scope* scope = Scope::current();
+    if (scope != NULL) {
+        scope->addCounter(name, value);
+    } else {
+        Profiler::getProfiler().addCounter(name, value);
+    }
+}
+
+inline void writeTrace(const std::string& filename) {
+    Profiler::getProfiler().writeTrace(filename);
+}
+
+inline void report(std::ostream* os) {
+    Profiler::getProfiler().report(os);
+}
+
+}  // namespace profile
+
+}  // namespace lime
+
+#endif  // SRC_CORE_PROFILE_DETAIL_H_
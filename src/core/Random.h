@@ -22,20 +22,49 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_CORE_RANDOM_H_
 #define SRC_CORE_RANDOM_H_
 
+#include <cstdint>
+
 namespace lime {
 
 /*
- * A singleton class for generating random numbers
+ * A counter-based random number generator (Philox4x32-10). A generator is
+ * identified by a key and a stream, and the n-th block of random numbers is
+ * computed from them directly. Thus, generators can be split and assigned to
+ * threads or pixels without sharing any state, and the results of parallel
+ * algorithms do not depend on the number of threads.
  */
 class Random {
  public:
+    /* Get the generator of the current thread. Each thread has its own generator
+     * whose key is the global seed and whose stream is the thread index.
+     * @param[in] seed: if non-negative, the global seed is reset to this value
+     */
     static Random& getRNG(int seed = -1);
 
- private:
-    explicit Random(int seed = -1);
-    Random& operator=(const Random& rand);
+    // * reset the global seed (generators of all the threads are reseeded)
+    static void setSeed(uint64_t seed);
+
+    /* Create a generator
+     * @param[in] seed: key of the generator
+     * @param[in] stream: stream index (generators with different streams are independent)
+     */
+    explicit Random(uint64_t seed, uint64_t stream = 0);
+
+    /* Create an independent generator. The parent is advanced,
+     * so that successive calls return different generators.
+     */
+    Random split();
+
+    /* Get a generator for the sub-stream "id". The result depends only on
+     * this generator's key and stream, and "id", so that parallel loops can
+     * use stream(i) for the i-th item and get reproducible results.
+     */
+    Random stream(uint64_t id) const;
+
+    /* Generate a random integer from [0, 2^32 - 1]
+        */
+    unsigned int randUInt() const;
 
- public:
     /* Generate a random integer from [0, n-1]
         */
     int randInt(const int n) const;
@@ -44,12 +73,47 @@ class Random {
         */
     double randReal() const;
 
-    /* Genrate a random number from a normal distribution with mean = 0 and STD = 1 */
+    /* Genrate a random number from a normal distribution with mean = 0 and STD = 1
+     * (Ziggurat method by Marsaglia and Tsang)
+     */
     double randNorm() const;
+
+    /* Fill an array with floating point random numbers from [0, 1)
+     * @param[out] out: output array
+     * @param[in] n: number of random numbers
+     */
+    void fill(float* out, int n) const;
+
+    /* Fill an array with random integers from [0, bound-1]
+     * @param[out] out: output array
+     * @param[in] n: number of random numbers
+     * @param[in] bound: upper bound (exclusive) of random integers
+     */
+    void fillInt(int* out, int n, int bound) const;
+
+    /* Fill an array with random numbers from a normal distribution with mean = 0 and STD = 1
+     * @param[out] out: output array
+     * @param[in] n: number of random numbers
+     */
+    void fillNormal(float* out, int n) const;
+
+ private:
+    void nextBlock() const;
+
+    // * write the next "n" raw 32-bit values (same sequence as successive randUInt calls)
+    void generate(unsigned int* out, int n) const;
+
+    // * slow path of the Ziggurat method for the raw value "u" (which has been rejected by the fast path)
+    double randNormTail(unsigned int u) const;
+
+    unsigned int key[2];
+    mutable unsigned int counter[4];
+    mutable unsigned int block[4];
+    mutable int index;
 };  // class Random
 
 }  // namespace lime
 
 #include "Random_detail.h"
 
-#endif  // SRC_CORE_RANDOM_H_ */
+#endif  // SRC_CORE_RANDOM_H_
@@ -1,60 +1,31 @@
-/*
-A C-program for MT19937, with initialization improved 2002/1/26.
-Coded by Takuji Nishimura and Makoto Matsumoto.
-
-Before using, initialize the state by using init_genrand(seed)
-or init_by_array(init_key, key_length).
-
-Copyright (C) 1997 - 2002, Makoto Matsumoto and Takuji Nishimura,
-All rights reserved.
-Copyright (C) 2005, Mutsuo Saito,
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions
-are met:
-
-1. Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-
-2. Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-
-3. The names of its contributors may not be used to endorse or promote
-products derived from this software without specific prior written
-permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
-CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
-EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
-PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
-PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
-LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
-NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-Any feedback is very welcome.
-http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/emt.html
-email: m-mat @ math.sci.hiroshima-u.ac.jp (remove space)
-
-**************************************************************************
-
-This header file is a C++ class wrapper of mt19937.c. Hense, please refer to
-the above comments to check the copyright of the source code.
-
-Thanks! 
-
-*/
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
 
 #ifndef SRC_CORE_RANDOM_DETAIL_H_
 #define SRC_CORE_RANDOM_DETAIL_H_
 
 #include <cmath>
+#include <algorithm>
 #include <ctime>
+#include <atomic>
 
 #include "common.hpp"
 
@@ -62,150 +33,333 @@ namespace lime {
 
 namespace {  // NOLINT
 
-/* Period parameters */
-const int N = 624;
-const int M = 397;
-const unsigned int MATRIX_A   = 0x9908b0dfU;  /* constant vector a */
-const unsigned int UPPER_MASK = 0x80000000U;  /* most significant w-r bits */
-const unsigned int LOWER_MASK = 0x7fffffffU;  /* least significant r bits */
-
-static unsigned int mt[N]; /* the array for the state vector  */
-static int mti = N + 1; /* mti==N+1 means mt[N] is not initialized */
-
-/* initializes mt[N] with a seed */
-void init_genrand(unsigned int s) {
-    mt[0] = s & 0xffffffffU;
-    for (mti = 1; mti < N; mti++) {
-        mt[mti] =
-            (1812433253UL * (mt[mti - 1] ^ (mt[mti - 1] >> 30)) + mti);
-        /* See Knuth TAOCP Vol2. 3rd Ed. P.106 for multiplier. */
-        /* In the previous versions, MSBs of the seed affect   */
-        /* only MSBs of the array mt[].                        */
-        /* 2002/01/09 modified by Makoto Matsumoto             */
-        mt[mti] &= 0xffffffffU;
-        /* for >32 bit machines */
-    }
-}
-
-/* initialize by an array with array-length */
-/* init_key is the array for initializing keys */
-/* key_length is its length */
-/* slight change for C++, 2004/2/26 */
-void init_by_array(unsigned int init_key[], int key_length) {
-    int i, j, k;
-    init_genrand(19650218U);
-    i = 1; j = 0;
-    k = (N > key_length ? N : key_length);
-    for (; k; k--) {
-        mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1664525UL))
-            + init_key[j] + j; /* non linear */
-        mt[i] &= 0xffffffffULL; /* for WORDSIZE > 32 machines */
-        i++; j++;
-        if (i >= N) { mt[0] = mt[N - 1]; i = 1; }
-        if (j >= key_length) j = 0;
-    }
-    for (k = N - 1; k; k--) {
-        mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1566083941UL))
-            - i; /* non linear */
-        mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
-        i++;
-        if (i >= N) { mt[0] = mt[N - 1]; i = 1; }
-    }
-
-    mt[0] = 0x80000000ULL; /* MSB is 1; assuring non-zero initial array */
-}
-
-/* generates a random number on [0,0xffffffff]-interval */
-unsigned int genrand_int32(void) {
-    unsigned int y;
-    static unsigned int mag01[2] = { 0x0U, MATRIX_A };
-    /* mag01[x] = x * MATRIX_A  for x=0,1 */
-
-    if (mti >= N) { /* generate N words at one time */
-        int kk;
-
-        if (mti == N + 1)   /* if init_genrand() has not been called, */
-            init_genrand(5489UL); /* a default initial seed is used */
-
-        for (kk = 0; kk < N - M; kk++) {
-            y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-            mt[kk] = mt[kk + M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-        }
-        for (; kk < N - 1; kk++) {
-            y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-            mt[kk] = mt[kk + (M - N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+/* Philox4x32 constants (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011) */
+const uint32_t PHILOX_M0 = 0xD2511F53U;
+const uint32_t PHILOX_M1 = 0xCD9E8D57U;
+const uint32_t PHILOX_W0 = 0x9E3779B9U;
+const uint32_t PHILOX_W1 = 0xBB67AE85U;
+const int PHILOX_ROUNDS = 10;
+
+/* encrypt a counter with a key by 10 rounds of Philox4x32 */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+        const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+        const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+        const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+/* Number of counters encrypted at once by the bulk generator. The lanes are
+ * kept in separate arrays so that the compiler can vectorize the rounds
+ * (8 lanes fill a 256-bit register with 32-bit words).
+ */
+const int PHILOX_LANES = 8;
+
+/* encrypt PHILOX_LANES successive counters starting from "ctr". The results are
+ * written in the order of the counters, i.e., out[4 * i + j] is the j-th word
+ * of the block for the counter ctr + i.
+ */
+void philox4x32Lanes(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4 * PHILOX_LANES]) {
+    uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+    for (int i = 0; i < PHILOX_LANES; i++) {
+        c0[i] = ctr[0] + static_cast<uint32_t>(i);
+        c1[i] = ctr[1] + (c0[i] < ctr[0] ? 1 : 0);
+        c2[i] = ctr[2];
+        c3[i] = ctr[3];
+    }
+
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        for (int i = 0; i < PHILOX_LANES; i++) {
+            const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0[i];
+            const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2[i];
+            const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+            const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+            c0[i] = hi1 ^ c1[i] ^ k0;
+            c1[i] = lo1;
+            c2[i] = hi0 ^ c3[i] ^ k1;
+            c3[i] = lo0;
         }
-        y = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
-        mt[N - 1] = mt[M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
 
-        mti = 0;
+    for (int i = 0; i < PHILOX_LANES; i++) {
+        out[4 * i + 0] = c0[i];
+        out[4 * i + 1] = c1[i];
+        out[4 * i + 2] = c2[i];
+        out[4 * i + 3] = c3[i];
     }
+}
 
-    y = mt[mti++];
+// * map a 32-bit value to a float in [0, 1) (24 bits are used, so the result never rounds up to 1)
+float uintToFloat(uint32_t u) {
+    return static_cast<float>(u >> 8) * (1.0f / 16777216.0f);
+}
 
-    /* Tempering */
-    y ^= (y >> 11);
-    y ^= (y << 7) & 0x9d2c5680ULL;
-    y ^= (y << 15) & 0xefc60000ULL;
-    y ^= (y >> 18);
+// * size of the temporary buffer used by the bulk generators
+const int BULK_BUFFER_SIZE = 256;
+
+/* Tables of the Ziggurat method (Marsaglia and Tsang, "The Ziggurat method for
+ * generating random variables", 2000) with 128 layers. They are read-only after
+ * the construction, so all the threads share them.
+ */
+const int ZIGGURAT_LAYERS = 128;
+const double ZIGGURAT_R = 3.442619855899;  // start of the tail
+const double ZIGGURAT_V = 9.91256303526217e-3;  // area of each layer
+
+struct ZigguratTable {
+    ZigguratTable() {
+        const double m = 2147483648.0;
+        double dn = ZIGGURAT_R;
+        double tn = dn;
+        const double q = ZIGGURAT_V / exp(-0.5 * dn * dn);
+        kn[0] = static_cast<uint32_t>((dn / q) * m);
+        kn[1] = 0;
+        wn[0] = q / m;
+        wn[ZIGGURAT_LAYERS - 1] = dn / m;
+        fn[0] = 1.0;
+        fn[ZIGGURAT_LAYERS - 1] = exp(-0.5 * dn * dn);
+        for (int i = ZIGGURAT_LAYERS - 2; i >= 1; i--) {
+            dn = sqrt(-2.0 * log(ZIGGURAT_V / dn + exp(-0.5 * dn * dn)));
+            kn[i + 1] = static_cast<uint32_t>((dn / tn) * m);
+            tn = dn;
+            fn[i] = exp(-0.5 * dn * dn);
+            wn[i] = dn / m;
+        }
+    }
 
-    return y;
+    uint32_t kn[ZIGGURAT_LAYERS];  // * thresholds of the fast path
+    double wn[ZIGGURAT_LAYERS];    // * widths of the layers (scaled by 2^-31)
+    double fn[ZIGGURAT_LAYERS];    // * density at the layer boundaries
+};
+
+const ZigguratTable& zigguratTable() {
+    static const ZigguratTable table;
+    return table;
 }
 
-/* generates a random number on [0,0x7fffffff]-interval */
-int genrand_int31(void) {
-    return static_cast<int>(genrand_int32() >> 1);
+/* Split a raw 32-bit value into the layer (lowest 7 bits) and a signed value
+ * (the remaining bits), so that the layer and the sample are not correlated.
+ */
+void zigguratSplit(uint32_t u, int* layer, int32_t* value) {
+    *layer = static_cast<int>(u & (ZIGGURAT_LAYERS - 1));
+    *value = static_cast<int32_t>(u & ~static_cast<uint32_t>(ZIGGURAT_LAYERS - 1));
 }
 
-/* generates a random number on [0,1]-real-interval */
-double genrand_real1(void) {
-    return genrand_int32()*(1.0 / 4294967295.0);
-    /* divided by 2^32-1 */
+uint32_t absValue(int32_t v) {
+    return v < 0 ? 0U - static_cast<uint32_t>(v) : static_cast<uint32_t>(v);
 }
 
-/* generates a random number on [0,1)-real-interval */
-double genrand_real2(void) {
-    return genrand_int32()*(1.0 / 4294967296.0);
-    /* divided by 2^32 */
+std::atomic<uint64_t>& globalSeed() {
+    static std::atomic<uint64_t> seed(static_cast<uint64_t>(time(0)));
+    return seed;
 }
 
-/* generates a random number on (0,1)-real-interval */
-double genrand_real3(void) {
-    return ((static_cast<double>(genrand_int32())) + 0.5)*(1.0 / 4294967296.0);
-    /* divided by 2^32 */
+std::atomic<unsigned int>& seedEpoch() {
+    static std::atomic<unsigned int> epoch(0);
+    return epoch;
 }
 
-/* generates a random number on [0,1) with 53-bit resolution*/
-double genrand_res53(void) {
-    unsigned int a = genrand_int32() >> 5, b = genrand_int32() >> 6;
-    return(a*67108864.0 + b)*(1.0 / 9007199254740992.0);
+unsigned int nextThreadStream() {
+    static std::atomic<unsigned int> nThreads(0);
+    return nThreads++;
 }
 
 }  // unnamed namespace
 
 inline Random& Random::getRNG(int seed) {
-    static Random instance(seed);
+    if (seed >= 0) {
+        setSeed(static_cast<uint64_t>(seed));
+    }
+
+    static thread_local unsigned int threadStream = nextThreadStream();
+    static thread_local unsigned int epoch = 0;
+    static thread_local Random instance(globalSeed().load(), threadStream);
+    const unsigned int current = seedEpoch().load();
+    if (epoch != current) {
+        instance = Random(globalSeed().load(), threadStream);
+        epoch = current;
+    }
     return instance;
 }
 
-inline Random::Random(int seed) {
-    unsigned int ulseed = seed >= 0 ? seed : (unsigned int)time(0);
-    init_genrand(ulseed);
+inline void Random::setSeed(uint64_t seed) {
+    globalSeed() = seed;
+    seedEpoch()++;
+}
+
+inline Random::Random(uint64_t seed, uint64_t stream)
+    : index(4) {
+    key[0] = static_cast<uint32_t>(seed);
+    key[1] = static_cast<uint32_t>(seed >> 32);
+    counter[0] = 0;
+    counter[1] = 0;
+    counter[2] = static_cast<uint32_t>(stream);
+    counter[3] = static_cast<uint32_t>(stream >> 32);
+}
+
+inline Random Random::split() {
+    nextBlock();
+    index = 4;
+    const uint64_t seed   = (static_cast<uint64_t>(block[1]) << 32) | block[0];
+    const uint64_t stream = (static_cast<uint64_t>(block[3]) << 32) | block[2];
+    return Random(seed, stream);
+}
+
+inline Random Random::stream(uint64_t id) const {
+    // the key of the sub-stream is a hash of (id, stream) by this generator's key
+    uint32_t ctr[4] = { static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32), counter[2], counter[3] };
+    uint32_t out[4];
+    philox4x32(ctr, key, out);
+    const uint64_t seed = (static_cast<uint64_t>(out[1]) << 32) | out[0];
+    return Random(seed, (static_cast<uint64_t>(out[3]) << 32) | out[2]);
+}
+
+inline void Random::nextBlock() const {
+    philox4x32(counter, key, block);
+    if (++counter[0] == 0) {
+        counter[1]++;
+    }
+    index = 0;
+}
+
+inline unsigned int Random::randUInt() const {
+    if (index >= 4) {
+        nextBlock();
+    }
+    return block[index++];
 }
 
 inline int Random::randInt(const int n) const {
     msg_assert(n > 0, "Upper bound of random integers must be positive.");
-    return genrand_int31() % n;
+    return static_cast<int>((static_cast<uint64_t>(randUInt()) * static_cast<uint64_t>(n)) >> 32);
 }
 
 inline double Random::randReal() const {
-    return genrand_real2();
+    return randUInt() * (1.0 / 4294967296.0);
 }
 
 inline double Random::randNorm() const {
-    double r1 = genrand_real3();
-    double r2 = genrand_real1();
-    return sqrt(-2.0 * log(r1)) * sin(2.0 * PI * r2);
+    const ZigguratTable& zig = zigguratTable();
+    const uint32_t u = randUInt();
+    int layer;
+    int32_t value;
+    zigguratSplit(u, &layer, &value);
+    if (absValue(value) < zig.kn[layer]) {
+        return value * zig.wn[layer];
+    }
+    return randNormTail(u);
+}
+
+inline double Random::randNormTail(unsigned int u) const {
+    const ZigguratTable& zig = zigguratTable();
+    int layer;
+    int32_t value;
+    zigguratSplit(u, &layer, &value);
+    for (;;) {
+        const double x = value * zig.wn[layer];
+        if (layer == 0) {
+            // sample from the tail beyond ZIGGURAT_R
+            double tx, ty;
+            do {
+                tx = -log(1.0 - randReal()) / ZIGGURAT_R;
+                ty = -log(1.0 - randReal());
+            } while (ty + ty < tx * tx);
+            return value > 0 ? ZIGGURAT_R + tx : -ZIGGURAT_R - tx;
+        }
+
+        if (zig.fn[layer] + randReal() * (zig.fn[layer - 1] - zig.fn[layer]) < exp(-0.5 * x * x)) {
+            return x;
+        }
+
+        zigguratSplit(randUInt(), &layer, &value);
+        if (absValue(value) < zig.kn[layer]) {
+            return value * zig.wn[layer];
+        }
+    }
+}
+
+inline void Random::generate(unsigned int* out, int n) const {
+    int i = 0;
+
+    // rest of the current block
+    while (i < n && index < 4) {
+        out[i++] = block[index++];
+    }
+
+    // whole blocks, PHILOX_LANES at once
+    while (n - i >= 4 * PHILOX_LANES) {
+        philox4x32Lanes(counter, key, out + i);
+        const uint32_t prev = counter[0];
+        counter[0] += PHILOX_LANES;
+        if (counter[0] < prev) {
+            counter[1]++;
+        }
+        i += 4 * PHILOX_LANES;
+    }
+
+    // tail
+    while (i < n) {
+        if (index >= 4) {
+            nextBlock();
+        }
+        out[i++] = block[index++];
+    }
+}
+
+inline void Random::fill(float* out, int n) const {
+    unsigned int buf[BULK_BUFFER_SIZE];
+    for (int i = 0; i < n; i += BULK_BUFFER_SIZE) {
+        const int m = std::min(BULK_BUFFER_SIZE, n - i);
+        generate(buf, m);
+        for (int k = 0; k < m; k++) {
+            out[i + k] = uintToFloat(buf[k]);
+        }
+    }
+}
+
+inline void Random::fillInt(int* out, int n, int bound) const {
+    msg_assert(bound > 0, "Upper bound of random integers must be positive.");
+    const uint64_t b = static_cast<uint64_t>(bound);
+    unsigned int buf[BULK_BUFFER_SIZE];
+    for (int i = 0; i < n; i += BULK_BUFFER_SIZE) {
+        const int m = std::min(BULK_BUFFER_SIZE, n - i);
+        generate(buf, m);
+        for (int k = 0; k < m; k++) {
+            out[i + k] = static_cast<int>((static_cast<uint64_t>(buf[k]) * b) >> 32);
+        }
+    }
+}
+
+inline void Random::fillNormal(float* out, int n) const {
+    // Ziggurat method on raw values drawn in bulk, only rejected values take the slow path
+    const ZigguratTable& zig = zigguratTable();
+    unsigned int buf[BULK_BUFFER_SIZE];
+    for (int i = 0; i < n; i += BULK_BUFFER_SIZE) {
+        const int m = std::min(BULK_BUFFER_SIZE, n - i);
+        generate(buf, m);
+        for (int k = 0; k < m; k++) {
+            int layer;
+            int32_t value;
+            zigguratSplit(buf[k], &layer, &value);
+            if (absValue(value) < zig.kn[layer]) {
+                out[i + k] = static_cast<float>(value * zig.wn[layer]);
+            } else {
+                out[i + k] = static_cast<float>(randNormTail(buf[k]));
+            }
+        }
+    }
 }
 
 }  // namespace lime
@@ -0,0 +1,76 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_TILING_H_
+#define SRC_CORE_TILING_H_
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+namespace lime {
+
+/*
+ * A tile of an image. Filters read the pixels in "region" (the tile extended by
+ * the halo, clipped to the image) and write only the pixels in "roi".
+ */
+struct Tile {
+    cv::Rect roi;
+    cv::Rect region;
+};
+
+/* Split an image into overlapping tiles
+ * @param[in] size: image size
+ * @param[in] tileSize: width and height of a tile (without the halo)
+ * @param[in] halo: number of pixels added to each side of a tile
+ */
+inline std::vector<Tile> makeTiles(const cv::Size& size, int tileSize, int halo);
+
+/* Execute func(tile) for every tile of an image in parallel
+ * @param[in] size: image size
+ * @param[in] tileSize: width and height of a tile (without the halo)
+ * @param[in] halo: number of pixels added to each side of a tile
+ * @param[in] func: function which takes a const reference to lime::Tile
+ */
+template <class Func>
+inline void forEachTile(const cv::Size& size, int tileSize, int halo, const Func& func);
+
+/* Apply a neighborhood filter tile by tile. Since the tiles are processed in parallel
+ * and each of them is filtered independently, peak memory of the filter's temporaries
+ * is bounded by the number of threads times the tile area instead of the image area.
+ * The result is the same as the filter applied to the whole image if the halo covers
+ * the support of the filter (see npr/Halo.h for the halo widths of lime's filters).
+ * @param[in] input: input image
+ * @param[out] output: output image (its type is taken from the output of the filter)
+ * @param[in] filter: function filter(const cv::Mat& in, cv::OutputArray out, const cv::Rect& region)
+ *                    where "in" is the input cropped to "region"
+ * @param[in] halo: number of pixels the filter needs around a tile
+ * @param[in] tileSize: width and height of a tile (without the halo)
+ */
+template <class Filter>
+inline void tiledFilter(cv::InputArray input, cv::OutputArray output, const Filter& filter,
+                        int halo, int tileSize = 512);
+
+}  // namespace lime
+
+#include "Tiling_detail.h"
+
+#endif  // SRC_CORE_TILING_H_
@@ -0,0 +1,93 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_CORE_TILING_DETAIL_H_
+#define SRC_CORE_TILING_DETAIL_H_
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#include "common.hpp"
+#include "Parallel.h"
+
+namespace lime {
+
+inline std::vector<Tile> makeTiles(const cv::Size& size, int tileSize, int halo) {
+    msg_assert(tileSize > 0, "Tile size must be positive.");
+    msg_assert(halo >= 0, "Halo width must be non-negative.");
+
+    const cv::Rect image(0, 0, size.width, size.height);
+    std::vector<Tile> tiles;
+    for (int y = 0; y < size.height; y += tileSize) {
+        for (int x = 0; x < size.width; x += tileSize) {
+            Tile tile;
+            tile.roi = cv::Rect(x, y, std::min(tileSize, size.width - x), std::min(tileSize, size.height - y));
+            tile.region = cv::Rect(x - halo, y - halo, tile.roi.width + 2 * halo, tile.roi.height + 2 * halo) & image;
+            tiles.push_back(tile);
+        }
+    }
+    return tiles;
+}
+
+template <class Func>
+void forEachTile(const cv::Size& size, int tileSize, int halo, const Func& func) {
+    const std::vector<Tile> tiles = makeTiles(size, tileSize, halo);
+    parallel_for(0, static_cast<int>(tiles.size()), [&](int i) {
+        func(tiles[i]);
+    }, 1);
+}
+
+template <class Filter>
+void tiledFilter(cv::InputArray input, cv::OutputArray output, const Filter& filter, int halo, int tileSize) {
+    cv::Mat  img = input.getMat();
+    cv::Mat& out = output.getMatRef();
+
+    // the input must not be overwritten while the other tiles read their halos
+    if (img.data == out.data) {
+        img = img.clone();
+    }
+
+    std::mutex mtx;
+    bool allocated = false;
+    forEachTile(img.size(), tileSize, halo, [&](const Tile& tile) {
+        cv::Mat tileOut;
+        filter(img(tile.region), tileOut, tile.region);
+        msg_assert(tileOut.rows == tile.region.height && tileOut.cols == tile.region.width,
+                   "Filter must return an image of the same size as the input tile.");
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!allocated) {
+                out.create(img.size(), tileOut.type());
+                allocated = true;
+            }
+        }
+
+        const cv::Rect local(tile.roi.x - tile.region.x, tile.roi.y - tile.region.y,
+                             tile.roi.width, tile.roi.height);
+        tileOut(local).copyTo(out(tile.roi));
+    });
+}
+
+}  // namespace lime
+
+#endif  // SRC_CORE_TILING_DETAIL_H_
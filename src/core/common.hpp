@@ -23,19 +23,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SRC_CORE_COMMON_HPP_
 
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 static const double PI = 4.0 * atan(1.0);
 
-#ifdef _OPENMP
-#include <omp.h>
-#define ompfor __pragma(omp parallel for) for
-#else  // _OPENMP
-#define ompfor for
-#endif  // _OPENMP
-
-#ifndef NDEBUG
-#define msg_assert(PREDICATE, MSG) \
+// * check kept in the release build, for the arguments which would crash the program otherwise
+#define msg_check(PREDICATE, MSG) \
 do { \
     if (!(PREDICATE)) { \
         std::cerr << "Asssertion \"" << #PREDICATE << "\" failed in " << __FILE__ \
@@ -43,6 +37,9 @@ do { \
         std::abort(); \
     } \
 } while (false)
+
+#ifndef NDEBUG
+#define msg_assert(PREDICATE, MSG) msg_check(PREDICATE, MSG)
 #else  // NDEBUG
 #define msg_assert(PREDICATE, MSG) do {} while (false)
 #endif  // NDEBUG
@@ -26,5 +26,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Point.hpp"
 #include "Array2d.h"
 #include "Random.h"
+#include "Parallel.h"
+#include "Profile.h"
+#include "Tiling.h"
+#include "FastMath.h"
 
 #endif  // SRC_LIME_CORE_HPP_
@@ -55,7 +55,7 @@ void random_queue<Ty>::push(Ty value) {
 
 template <class Ty>
 Ty random_queue<Ty>::pop() {
-    Random rand = Random::getRNG();
+    Random& rand = Random::getRNG();
     int i = rand.randInt(static_cast<int>(ptr));
     ptr--;
     std::swap(data[i], data[ptr]);
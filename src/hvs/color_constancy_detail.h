@@ -25,6 +25,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <algorithm>
 
+#include "../core/common.hpp"
+#include "../core/Profile.h"
+
 namespace lime {
 
 namespace {  // NOLINT
@@ -254,23 +257,32 @@ void highEnhanceFilter(cv::InputArray input_, cv::OutputArray output_) {
 }  // unnamed namespace
 
 void colorConstancyHorn(cv::InputArray input, cv::OutputArray output, double thre) {
+    LIME_PROFILE_SCOPE("colorConstancyHorn");
     cv::Mat  img = input.getMat();
     cv::Mat& out = output.getMatRef();
     cv::Mat laplace;
+    LIME_PROFILE_COUNT("pixels", img.rows * img.cols);
 
     logarithm(img, out);
     laplacian(out, laplace);
     threshold(laplace, laplace, thre);
-    gauss_seidel(out, laplace, 20);
+    {
+        LIME_PROFILE_SCOPE("gauss_seidel");
+        LIME_PROFILE_COUNT("iterations", 20);
+        gauss_seidel(out, laplace, 20);
+    }
     normalizeCC(out, out);
     exponential(out, out);
 }
 
 void colorConstancyRahman(cv::InputArray input, cv::OutputArray output, double sigma, double scale, int nLevel) {
+    LIME_PROFILE_SCOPE("colorConstancyRahman");
     msg_assert(input.depth() == CV_32F, "Input cv::Mat must be CV_32 depth");
 
     cv::Mat  img = input.getMat();
     cv::Mat& out = output.getMatRef();
+    LIME_PROFILE_COUNT("pixels", img.rows * img.cols);
+    LIME_PROFILE_COUNT("levels", nLevel);
 
     cv::Mat gauss, tmp;
 
@@ -303,10 +315,12 @@ void colorConstancyRahman(cv::InputArray input, cv::OutputArray output, double s
 }
 
 void colorConstancyFaugeras(cv::InputArray input, cv::OutputArray output) {
+    LIME_PROFILE_SCOPE("colorConstancyFaugeras");
     msg_assert(input.depth() == CV_32F, "Input cv::Mat must be CV_32 depth");
 
     cv::Mat  img = input.getMat();
     cv::Mat& out = output.getMatRef();
+    LIME_PROFILE_COUNT("pixels", img.rows * img.cols);
 
     const int width = img.cols;
     const int height = img.rows;
@@ -0,0 +1,158 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_COMPACTVECTORFIELD_DETAIL_H_
+#define SRC_NPR_COMPACTVECTORFIELD_DETAIL_H_
+
+#include <cmath>
+
+#include "../core/common.hpp"
+#include "../core/FastMath.h"
+#include "../core/Parallel.h"
+
+namespace lime {
+
+namespace npr {
+
+namespace {  // NOLINT
+
+/* Unit vectors of the quantized angles, followed by the zero vector for
+ * ZERO_CODE. The table is read-only after the construction, so all the
+ * threads share it.
+ */
+struct DirectionTable {
+    DirectionTable() {
+        const int levels = CompactVectorField::ANGLE_LEVELS;
+        for (int i = 0; i < levels; i++) {
+            const double theta = 2.0 * PI * i / levels;
+            unit[i] = cv::Point2f(static_cast<float>(cos(theta)), static_cast<float>(sin(theta)));
+        }
+        unit[levels] = cv::Point2f(0.0f, 0.0f);
+    }
+
+    cv::Point2f unit[CompactVectorField::ANGLE_LEVELS + 1];
+};
+
+const DirectionTable& directionTable() {
+    static const DirectionTable table;
+    return table;
+}
+
+// * code of the nearest quantized angle
+uint16_t encodeAngle(double theta) {
+    const int levels = CompactVectorField::ANGLE_LEVELS;
+    if (!std::isfinite(theta)) return CompactVectorField::ZERO_CODE;
+
+    const double t = theta * (levels / (2.0 * PI));
+    int code = static_cast<int>(std::fmod(floor(t + 0.5), static_cast<double>(levels)));
+    if (code < 0) code += levels;
+    return static_cast<uint16_t>(code);
+}
+
+}  // unnamed namespace
+
+inline CompactVectorField::CompactVectorField()
+    : codes()
+    , scale(1.0f)
+    , table(directionTable().unit) {
+}
+
+inline CompactVectorField::CompactVectorField(cv::InputArray field, double length)
+    : codes()
+    , scale(static_cast<float>(length))
+    , table(directionTable().unit) {
+    cv::Mat F = field.getMat();
+    msg_assert(F.depth() == CV_32F && (F.channels() == 1 || F.channels() == 2),
+        "Vector field must be CV_32FC1 angles or CV_32FC2 vectors.");
+
+    const int width = F.cols;
+    const int height = F.rows;
+    codes = Array2d<uint16_t>(height, width);
+    if (F.channels() == 1) {
+        parallel_for(0, height, [&](int y) {
+            const float* src = F.ptr<float>(y);
+            uint16_t* dst = codes.ptr(y);
+            for (int x = 0; x < width; x++) {
+                dst[x] = encodeAngle(src[x]);
+            }
+        });
+    } else {
+        parallel_for(0, height, [&](int y) {
+            const float* src = F.ptr<float>(y);
+            uint16_t* dst = codes.ptr(y);
+            for (int x = 0; x < width; x++) {
+                const float vx = src[x * 2 + 0];
+                const float vy = src[x * 2 + 1];
+                if (vx == 0.0f && vy == 0.0f) {
+                    dst[x] = ZERO_CODE;
+                } else {
+                    dst[x] = encodeAngle(fastAtan2(vy, vx));
+                }
+            }
+        });
+    }
+}
+
+inline int CompactVectorField::rows() const {
+    return codes.rows();
+}
+
+inline int CompactVectorField::cols() const {
+    return codes.cols();
+}
+
+inline bool CompactVectorField::empty() const {
+    return codes.rows() == 0 || codes.cols() == 0;
+}
+
+inline double CompactVectorField::length() const {
+    return scale;
+}
+
+inline cv::Point2f CompactVectorField::operator()(int y, int x) const {
+    const cv::Point2f& u = table[codes.ptr(y)[x]];
+    return cv::Point2f(scale * u.x, scale * u.y);
+}
+
+inline const uint16_t* CompactVectorField::ptr(int y) const {
+    return codes.ptr(y);
+}
+
+inline void CompactVectorField::toMat(cv::OutputArray vfield) const {
+    const int width = cols();
+    const int height = rows();
+    cv::Mat& V = vfield.getMatRef();
+    V = cv::Mat(height, width, CV_32FC2);
+    parallel_for(0, height, [&](int y) {
+        float* dst = V.ptr<float>(y);
+        for (int x = 0; x < width; x++) {
+            const cv::Point2f v = (*this)(y, x);
+            dst[x * 2 + 0] = v.x;
+            dst[x * 2 + 1] = v.y;
+        }
+    });
+}
+
+}  // namespace npr
+
+}  // namespace lime
+
+#endif  // SRC_NPR_COMPACTVECTORFIELD_DETAIL_H_
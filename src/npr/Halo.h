@@ -0,0 +1,89 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_HALO_H_
+#define SRC_NPR_HALO_H_
+
+#include "NPREdges.h"
+#include "VectorField.h"
+#include "../npr/lic.h"
+
+namespace lime {
+
+namespace npr {
+
+/*
+ * Halo widths of the NPR filters for lime::tiledFilter. Each function returns the
+ * number of pixels around a tile which affect the filtered values inside the tile,
+ * so that the tiled result is the same as that of the whole image. The exceptions
+ * are LIC_CLASSIC and LIC_FAST, whose results are only approximate under tiling.
+ */
+namespace halo {
+
+    // * halo for edgeDoG (FDoG includes the vector field and the flow-based smoothing)
+    inline int edgeDoG(const DoGParam& param);
+
+    /* halo for calcVectorField
+     * @param[in] ksize: kernel size passed to calcVectorField
+     * @param[in] vfieldType: algorithm to detect vector field
+     */
+    inline int vectorField(int ksize, VFieldType vfieldType = VECTOR_SST);
+
+    /* halo for lic
+     * LIC_CLASSIC steps to the next lattice crossing and LIC_FAST seeds its streamlines
+     * from the pixels of the tile, so both depend on the position of the tile and the
+     * tiled result differs slightly from the whole one however wide the halo is.
+     * @param[in] L: convolution length
+     * @param[in] algo: algorithm type used for LIC
+     * @param[in] maxSpeed: maximum length of the vectors in the vector field
+     */
+    inline int lic(int L, LicAlgo algo = LIC_EULARIAN, double maxSpeed = 1.0);
+
+    // * halo for solveAD
+    inline int solveAD(int maxiter);
+
+    // * halo for solveSF
+    inline int solveSF(int maxiter);
+
+    // * halo for solveMCF
+    inline int solveMCF(int maxiter);
+
+    // * halo for the morphological filters (covers the compound ones such as opening and closing)
+    inline int morphology(int ksize);
+
+    // * halo for kuwaharaFilter
+    inline int kuwahara(int ksize);
+
+    // * halo for generalKF
+    inline int generalKF(int ksize);
+
+    // * halo for anisoKF
+    inline int anisoKF(int ksize);
+
+}  // namespace halo
+
+}  // namespace npr
+
+}  // namespace lime
+
+#include "Halo_detail.h"
+
+#endif  // SRC_NPR_HALO_H_
@@ -0,0 +1,115 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_HALO_DETAIL_H_
+#define SRC_NPR_HALO_DETAIL_H_
+
+#include <cmath>
+#include <algorithm>
+
+#include "../core/common.hpp"
+
+namespace lime {
+
+namespace npr {
+
+namespace halo {
+
+    int edgeDoG(const DoGParam& param) {
+        if (param.dogType == EDGE_FDOG) {
+            // streamlines of the scaled vectors, at whose samples the vector field and
+            // the Gaussian across the flow are evaluated
+            const int step = static_cast<int>(ceil(FDOG_VFIELD_SCALE));
+            const int across = static_cast<int>(ceil(0.5 * FDOG_VFIELD_SCALE * FDOG_KSIZE));
+            return step * flowLength(FDOG_KSIZE) + 1 + std::max(vectorField(FDOG_VFIELD_KSIZE, VECTOR_SST), across);
+        }
+
+        // OpenCV's Gaussian kernel covers 4 sigma for floating-point images
+        return static_cast<int>(ceil(4.0 * param.kappa * param.sigma)) + 1;
+    }
+
+    int vectorField(int ksize, VFieldType vfieldType) {
+        if (vfieldType == VECTOR_ETF || vfieldType == VECTOR_ETF_SEPARABLE) {
+            // 3x3 edge detector and the iterations of smoothing with radius ksize
+            return 1 + ETF_ITERATIONS * ksize;
+        }
+
+        // 3x3 edge detector, the steps of tensor relaxation and box filter of ksize
+        return 1 + SST_RELAX_ITERATIONS + ksize / 2;
+    }
+
+    int lic(int L, LicAlgo algo, double maxSpeed) {
+        const int step = static_cast<int>(ceil(maxSpeed));
+        if (algo == LIC_CLASSIC) {
+            // 2 iterations, each of which traces streamlines of arc length L; the lattice
+            // crossings depend on the absolute coordinates, so that the result is approximate
+            return 2 * (L + 1);
+        }
+
+        if (algo == LIC_FAST) {
+            // box kernel of L samples on each side, but the streamlines are seeded
+            // differently in each tile, so that the result is only close to the whole one
+            return L * step + 1;
+        }
+
+        // 3 iterations, each of which traces L steps (and a half step for Runge-Kutta)
+        return 3 * (L * step + 1);
+    }
+
+    int solveAD(int maxiter) {
+        return std::max(maxiter, 0) + 1;
+    }
+
+    int solveSF(int maxiter) {
+        // Laplacian of the aperture 11 is recomputed at every iteration
+        return 6 * (std::max(maxiter, 0) + 1);
+    }
+
+    int solveMCF(int maxiter) {
+        // curvature at the neighbors, and 2-pixel border which is kept unchanged
+        return 2 * std::max(maxiter, 0) + 2;
+    }
+
+    int morphology(int ksize) {
+        return 2 * ksize;
+    }
+
+    int kuwahara(int ksize) {
+        return ksize;
+    }
+
+    int generalKF(int ksize) {
+        return ksize;
+    }
+
+    int anisoKF(int ksize) {
+        // the kernel is rotated and stretched up to twice along the minor axis
+        const int kernel = static_cast<int>(ceil(2.0 * sqrt(2.0) * ksize)) + 1;
+        return std::max(kernel, vectorField(5, VECTOR_SST));
+    }
+
+}  // namespace halo
+
+}  // namespace npr
+
+}  // namespace lime
+
+#endif  // SRC_NPR_HALO_DETAIL_H_
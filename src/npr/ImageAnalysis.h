@@ -0,0 +1,87 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_IMAGEANALYSIS_H_
+#define SRC_NPR_IMAGEANALYSIS_H_
+
+#include <opencv2/opencv.hpp>
+
+namespace lime {
+
+namespace npr {
+
+enum EdgeDetector {
+    EDGE_SOBEL,
+    EDGE_ROTATIONAL
+};
+
+/* Gray image and its gradients, which are computed once and shared by the
+ * filters analyzing the same image, such as calcVectorField, calcSST,
+ * calcETF and filter::calcTangent.
+ */
+class ImageAnalysis {
+ public:
+    ImageAnalysis();
+
+    /* Analyze the image
+     * @param[in] image: input image (8-bit images are scaled into [0, 1])
+     * @param[in] edgeDetector: 3x3 stencil for the gradients
+     */
+    explicit ImageAnalysis(cv::InputArray image, EdgeDetector edgeDetector = EDGE_SOBEL);
+
+    int rows() const;
+
+    int cols() const;
+
+    EdgeDetector edgeDetector() const;
+
+    // * gray image (CV_32FC1)
+    const cv::Mat& gray() const;
+
+    // * horizontal gradients (CV_32FC1)
+    const cv::Mat& gradX() const;
+
+    // * vertical gradients (CV_32FC1)
+    const cv::Mat& gradY() const;
+
+    // * gradient magnitude (CV_32FC1)
+    const cv::Mat& magnitude() const;
+
+ private:
+    EdgeDetector detector;
+    cv::Mat grayImage, gx, gy, mag;
+};  // class ImageAnalysis
+
+/* Rotation-invariant 3x3 gradients, which are the same as those of ImageAnalysis
+ * with EDGE_ROTATIONAL. The pixels outside the image are regarded as zero.
+ * @param[in] image: input image (8-bit images are scaled into [0, 1])
+ * @param[out] gx: horizontal gradients (CV_32FC1)
+ * @param[out] gy: vertical gradients (CV_32FC1)
+ */
+inline void rotationalGradient(cv::InputArray image, cv::OutputArray gx, cv::OutputArray gy);
+
+}  // namespace npr
+
+}  // namespace lime
+
+#include "ImageAnalysis_detail.h"
+
+#endif  // SRC_NPR_IMAGEANALYSIS_H_
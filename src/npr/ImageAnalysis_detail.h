@@ -0,0 +1,228 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_IMAGEANALYSIS_DETAIL_H_
+#define SRC_NPR_IMAGEANALYSIS_DETAIL_H_
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "../core/common.hpp"
+#include "../core/Parallel.h"
+#include "../core/Profile.h"
+
+namespace lime {
+
+namespace npr {
+
+namespace {  // NOLINT
+
+// * index of reflected border (same as cv::BORDER_REFLECT_101)
+int reflect101(int p, int n) {
+    if (n == 1) return 0;
+    while (p < 0 || p >= n) {
+        if (p < 0) p = -p;
+        if (p >= n) p = 2 * n - 2 - p;
+    }
+    return p;
+}
+
+// * gray image of CV_32FC1 whose intensities are in [0, 1]
+cv::Mat grayImage32F(const cv::Mat& image) {
+    const int dim = image.channels();
+
+    cv::Mat gray;
+    if (image.depth() != CV_32F) {
+        image.convertTo(gray, CV_MAKETYPE(CV_32F, dim), 1.0 / 255.0);
+    } else {
+        image.convertTo(gray, CV_MAKETYPE(CV_32F, dim));
+    }
+
+    if (dim != 1) {
+        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+    }
+    return gray;
+}
+
+// * weights (a, b) of the 3x3 stencil (see gradientRow)
+void stencilWeights(EdgeDetector edgeDetector, float* a, float* b) {
+    if (edgeDetector == EDGE_SOBEL) {
+        *a = 1.0f;
+        *b = 2.0f;
+    } else if (edgeDetector == EDGE_ROTATIONAL) {
+        const float p1 = 0.183f;
+        *a = -0.5f * p1;
+        *b = p1 - 0.5f;
+    } else {
+        msg_assert(false, "Unknown edge detector is specified.");
+    }
+}
+
+/* 3x3 gradients of a row. Sobel reflects the border pixels as cv::Sobel does,
+ * while the rotational stencil ignores the pixels outside the image. Both
+ * stencils are the differences of three rows (or columns) weighted by
+ * (a, b, a). The interior pixels are read from the image directly by the
+ * loop without branches, which is vectorized, and only the first and the
+ * last rows and columns look up the pixels outside the image.
+ */
+void gradientRow(const cv::Mat& gray, int y, EdgeDetector edgeDetector, float* gx, float* gy) {
+    const int width = gray.cols;
+    const int height = gray.rows;
+
+    float a = 0.0f;
+    float b = 0.0f;
+    stencilWeights(edgeDetector, &a, &b);
+    const bool reflect = edgeDetector == EDGE_SOBEL;
+
+    // rows around y, which are padded copies only at the top and bottom borders
+    std::vector<float> buffer;
+    const float* rows[3];
+    if (y >= 1 && y < height - 1) {
+        for (int k = 0; k < 3; k++) {
+            rows[k] = gray.ptr<float>(y + k - 1);
+        }
+    } else {
+        buffer.assign(width * 3, 0.0f);
+        for (int k = 0; k < 3; k++) {
+            float* row = &buffer[k * width];
+            rows[k] = row;
+            int yy = y + k - 1;
+            if (yy < 0 || yy >= height) {
+                if (!reflect) continue;
+                yy = reflect101(yy, height);
+            }
+            memcpy(row, gray.ptr<float>(yy), sizeof(float) * width);
+        }
+    }
+
+    const float* r0 = rows[0];
+    const float* r1 = rows[1];
+    const float* r2 = rows[2];
+    for (int x = 1; x < width - 1; x++) {
+        gx[x] = a * (r0[x + 1] - r0[x - 1]) + b * (r1[x + 1] - r1[x - 1]) + a * (r2[x + 1] - r2[x - 1]);
+        gy[x] = a * (r2[x - 1] - r0[x - 1]) + b * (r2[x] - r0[x]) + a * (r2[x + 1] - r0[x + 1]);
+    }
+
+    // first and last columns
+    const int borders[2] = { 0, width - 1 };
+    for (int i = 0; i < (width > 1 ? 2 : 1); i++) {
+        const int x = borders[i];
+        float p[3][3];
+        for (int j = 0; j < 3; j++) {
+            int xx = x + j - 1;
+            const bool inside = xx >= 0 && xx < width;
+            if (!inside && reflect) xx = reflect101(xx, width);
+            for (int k = 0; k < 3; k++) {
+                p[k][j] = inside || reflect ? rows[k][xx] : 0.0f;
+            }
+        }
+        gx[x] = a * (p[0][2] - p[0][0]) + b * (p[1][2] - p[1][0]) + a * (p[2][2] - p[2][0]);
+        gy[x] = a * (p[2][0] - p[0][0]) + b * (p[2][1] - p[0][1]) + a * (p[2][2] - p[0][2]);
+    }
+}
+
+}  // unnamed namespace
+
+inline ImageAnalysis::ImageAnalysis()
+    : detector(EDGE_SOBEL)
+    , grayImage()
+    , gx()
+    , gy()
+    , mag() {
+}
+
+inline ImageAnalysis::ImageAnalysis(cv::InputArray image, EdgeDetector edgeDetector)
+    : detector(edgeDetector)
+    , grayImage()
+    , gx()
+    , gy()
+    , mag() {
+    LIME_PROFILE_SCOPE("ImageAnalysis");
+    grayImage = grayImage32F(image.getMat());
+
+    const int width = grayImage.cols;
+    const int height = grayImage.rows;
+    LIME_PROFILE_COUNT("pixels", width * height);
+
+    gx = cv::Mat(height, width, CV_32FC1);
+    gy = cv::Mat(height, width, CV_32FC1);
+    mag = cv::Mat(height, width, CV_32FC1);
+    parallel_for(0, height, [&](int y) {
+        float* dx = gx.ptr<float>(y);
+        float* dy = gy.ptr<float>(y);
+        float* m = mag.ptr<float>(y);
+        gradientRow(grayImage, y, detector, dx, dy);
+        for (int x = 0; x < width; x++) {
+            m[x] = std::sqrt(dx[x] * dx[x] + dy[x] * dy[x]);
+        }
+    });
+}
+
+inline int ImageAnalysis::rows() const {
+    return grayImage.rows;
+}
+
+inline int ImageAnalysis::cols() const {
+    return grayImage.cols;
+}
+
+inline EdgeDetector ImageAnalysis::edgeDetector() const {
+    return detector;
+}
+
+inline const cv::Mat& ImageAnalysis::gray() const {
+    return grayImage;
+}
+
+inline const cv::Mat& ImageAnalysis::gradX() const {
+    return gx;
+}
+
+inline const cv::Mat& ImageAnalysis::gradY() const {
+    return gy;
+}
+
+inline const cv::Mat& ImageAnalysis::magnitude() const {
+    return mag;
+}
+
+inline void rotationalGradient(cv::InputArray image, cv::OutputArray gx, cv::OutputArray gy) {
+    LIME_PROFILE_SCOPE("rotationalGradient");
+    const cv::Mat gray = grayImage32F(image.getMat());
+    const int width = gray.cols;
+    const int height = gray.rows;
+    LIME_PROFILE_COUNT("pixels", width * height);
+
+    cv::Mat& dx = gx.getMatRef();
+    cv::Mat& dy = gy.getMatRef();
+    dx.create(height, width, CV_32FC1);
+    dy.create(height, width, CV_32FC1);
+    parallel_for(0, height, [&](int y) {
+        gradientRow(gray, y, EDGE_ROTATIONAL, dx.ptr<float>(y), dy.ptr<float>(y));
+    });
+}
+
+}  // namespace npr
+
+}  // namespace lime
+
+#endif  // SRC_NPR_IMAGEANALYSIS_DETAIL_H_
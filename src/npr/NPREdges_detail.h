@@ -22,6 +22,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_NPR_NPREDGES_DETAIL_H_
 #define SRC_NPR_NPREDGES_DETAIL_H_
 
+#include <vector>
+#include <algorithm>
+
+#include "../core/Parallel.h"
+#include "../core/Profile.h"
+#include "../core/Random.h"
 #include "VectorField.h"
 #include "../npr/lic.h"
 
@@ -53,20 +59,41 @@ void uniformNoise(cv::OutputArray noise, const cv::InputArray gray, int nNoise)
     const int width  = img.cols;
     const int height = img.rows;
 
-    Random rand = Random::getRNG();
+    Random& rand = Random::getRNG();
 
     out = cv::Mat::zeros(height, width, CV_32FC1);
+
+    // candidates are drawn in batches
+    const int batch = 1024;
+    std::vector<int> xs(batch), ys(batch);
+    std::vector<float> rs(batch);
     int count = 0;
     while (count < nNoise) {
-        int x = rand.randInt(width);
-        int y = rand.randInt(height);
-        if (rand.randReal() < img.at<float>(y, x)) continue;
-        out.at<float>(y, x) = 1.0f;
-        count++;
+        rand.fillInt(&xs[0], batch, width);
+        rand.fillInt(&ys[0], batch, height);
+        rand.fill(&rs[0], batch);
+        for (int i = 0; i < batch && count < nNoise; i++) {
+            if (rs[i] < img.at<float>(ys[i], xs[i])) continue;
+            out.at<float>(ys[i], xs[i]) = 1.0f;
+            count++;
+        }
     }
 }
 
+// * half length of the flow-based Gaussians of FDoG across the flow
+const int FDOG_KSIZE = 10;
+
+// * kernel size and length of the vectors of the flow traced by FDoG
+const int FDOG_VFIELD_KSIZE = 11;
+const double FDOG_VFIELD_SCALE = 2.0;
+
+// * number of the steps of the streamlines along which gaussWithFlow smooths
+int flowLength(int ksize) {
+    return static_cast<int>(ksize * 1.5);
+}
+
 void edgeXDoG(cv::InputArray input, cv::OutputArray output, const DoGParam& param) {
+    LIME_PROFILE_SCOPE("edgeXDoG");
     cv::Mat  gray = input.getMat();
     cv::Mat& edge = output.getMatRef();
 
@@ -91,23 +118,26 @@ void edgeXDoG(cv::InputArray input, cv::OutputArray output, const DoGParam& para
     }
 }
 
-void gaussWithFlow(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfield,
+template <class VectorField2f>
+void gaussWithFlow(cv::InputArray input, cv::OutputArray output, const VectorField2f& vfield,
     int ksize, double sigma_s, double sigma_t) {
+    LIME_PROFILE_SCOPE("gaussWithFlow");
     cv::Mat  image = input.getMat();
     cv::Mat& out = output.getMatRef();
 
     const int width = image.cols;
     const int height = image.rows;
     const int dim = image.channels();
-    const int L = static_cast<int>(ksize * 1.5);
+    const int L = flowLength(ksize);
     out = cv::Mat::zeros(height, width, CV_MAKETYPE(CV_32F, dim));
 
     cv::Mat temp = cv::Mat::zeros(height, width, CV_MAKETYPE(CV_32F, dim));
 
-    ompfor(int y = 0; y < height; y++) {
+    parallel_for(0, height, [&](int y) {
         for (int x = 0; x < width; x++) {
-            double tx = vfield.at<float>(y, x * 2 + 0);
-            double ty = vfield.at<float>(y, x * 2 + 1);
+            const cv::Point2f t0 = vfield(y, x);
+            double tx = t0.x;
+            double ty = t0.y;
             double weight = 0.0;
             for (int t = -ksize; t <= ksize; t++) {
                 int xx = static_cast<int>(x - 0.5 * ty * t);
@@ -125,70 +155,46 @@ void gaussWithFlow(cv::InputArray input, cv::OutputArray output, const cv::Mat&
                 temp.at<float>(y, x*dim + c) = temp.at<float>(y, x*dim + c) / static_cast<float>(weight);
             }
         }
-    }
+    });
 
-    ompfor(int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            double weight = 0.0;
-            for (int c = 0; c < dim; c++) {
-                out.at<float>(y, x*dim + c) = 0.0f;
-            }
-
-            for (int pm = -1; pm <= 1; pm += 2) {
-                int l = 0;
-                double tx = pm * vfield.at<float>(y, x * 2 + 0);
-                double ty = pm * vfield.at<float>(y, x * 2 + 1);
-                Point2d pt = Point2d(x + 0.5, y + 0.5);
-                while (++l < L) {
-                    int px = static_cast<int>(ceil(pt.x));
-                    int py = static_cast<int>(ceil(pt.y));
-                    if (px < 0 || py < 0 || px >= width || py >= height) {
-                        break;
-                    }
-
-                    double w = exp(-l * l / sigma_s);
-                    for (int c = 0; c < dim; c++) {
-                        out.at<float>(y, x*dim + c) += static_cast<float>(w * temp.at<float>(py, px*dim + c));
-                    }
-                    weight += w;
-
-                    double vx = vfield.at<float>(py, px * 2 + 0);
-                    double vy = vfield.at<float>(py, px * 2 + 1);
-                    if (vx == 0.0f && vy == 0.0f) {
-                        break;
-                    }
-
-                    double inner = vx * tx + vy * ty;
-                    double sx = sign(inner) * vx;
-                    double sy = sign(inner) * vy;
-                    px = static_cast<int>(ceil(pt.x + 0.5 * sx));
-                    py = static_cast<int>(ceil(pt.y + 0.5 * sy));
-                    if (px < 0 || py < 0 || px >= width || py >= height) {
-                        break;
-                    }
+    // smoothing along the streamlines, which are traced with the midpoint rule in lock-step
+    std::vector<double> kernel(std::max(L, 1));
+    for (int l = 0; l < L; l++) {
+        kernel[l] = exp(-l * l / sigma_s);
+    }
 
-                    vx = vfield.at<float>(py, px * 2 + 0);
-                    vy = vfield.at<float>(py, px * 2 + 1);
-                    inner = vx * tx + vy * ty;
-                    tx = sign(inner) * vx;
-                    ty = sign(inner) * vy;
-                    pt.x += tx;
-                    pt.y += ty;
+    parallel_for(0, height, [&](int y) {
+        std::vector<float> acc(LIC_LANES * dim);
+        for (int x0 = 0; x0 < width; x0 += LIC_LANES) {
+            const int n = std::min(LIC_LANES, width - x0);
+            double weight[LIC_LANES] = {};
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            auto emit = [&](int i, int px, int py, double w, double) {
+                const float* p = temp.ptr<float>(py) + px * dim;
+                for (int c = 0; c < dim; c++) {
+                    acc[i * dim + c] += static_cast<float>(w * p[c]);
                 }
-            }
-
-            for (int c = 0; c < dim; c++) {
-                if (weight != 0.0) {
-                    out.at<float>(y, x*dim + c) = out.at<float>(y, x*dim + c) / static_cast<float>(weight);
-                } else {
-                    out.at<float>(y, x*dim + c) = temp.at<float>(y, x*dim + c);
+                weight[i] += w;
+            };
+            traceLanes<true>(vfield, width, height, x0, y, n, L, &kernel[0], emit);
+
+            for (int i = 0; i < n; i++) {
+                const int x = x0 + i;
+                for (int c = 0; c < dim; c++) {
+                    if (weight[i] != 0.0) {
+                        out.at<float>(y, x*dim + c) = acc[i * dim + c] / static_cast<float>(weight[i]);
+                    } else {
+                        out.at<float>(y, x*dim + c) = temp.at<float>(y, x*dim + c);
+                    }
                 }
             }
         }
-    }
+    });
 }
 
-void edgeFDoG(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfield, const DoGParam& param) {
+template <class VectorField2f>
+void edgeFDoG(cv::InputArray input, cv::OutputArray output, const VectorField2f& vfield, const DoGParam& param) {
+    LIME_PROFILE_SCOPE("edgeFDoG");
     cv::Mat  gray = input.getMat();
     cv::Mat& edge = output.getMatRef();
 
@@ -196,13 +202,7 @@ void edgeFDoG(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfiel
     const int height = gray.rows;
     const int dim = gray.channels();
 
-    if (vfield.empty()) {
-        cv::Mat angles;
-        npr::calcVectorField(gray, angles, 11);
-        npr::angle2vector(angles, vfield, 2.0);
-    }
-
-    const int ksize = 10;
+    const int ksize = FDOG_KSIZE;
 
     const double alpha = 2.0;
     const double sigma2 = 2.0 * param.sigma * param.sigma;
@@ -235,7 +235,9 @@ void edgeFDoG(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfiel
 }  // unnamed namespace
 
 void edgeDoG(cv::InputArray image, cv::OutputArray edge, const DoGParam& param) {
+    LIME_PROFILE_SCOPE("edgeDoG");
     cv::Mat input = image.getMat();
+    LIME_PROFILE_COUNT("pixels", input.rows * input.cols);
     msg_assert(input.depth() == CV_32F && input.channels() == 1,
         "Input image must be single channel and floating-point-valued.");
 
@@ -246,9 +248,13 @@ void edgeDoG(cv::InputArray image, cv::OutputArray edge, const DoGParam& param)
         edgeXDoG(input, outRef, param);
         break;
 
-    case EDGE_FDOG:
-        edgeFDoG(input, outRef, cv::Mat(), param);
+    case EDGE_FDOG: {
+        // * the flow is traced through the compact field to save the memory traffic
+        cv::Mat angles;
+        npr::calcVectorField(input, angles, FDOG_VFIELD_KSIZE);
+        edgeFDoG(input, outRef, CompactVectorField(angles, FDOG_VFIELD_SCALE), param);
         break;
+    }
 
     default:
         msg_assert(false, "Unknown DoG type is specified.");
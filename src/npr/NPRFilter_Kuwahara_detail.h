@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 
 #include "../core/common.hpp"
+#include "../core/Parallel.h"
 #include "NPREdges.h"
 #include "VectorField.h"
 
@@ -40,89 +41,62 @@ namespace {  // NOLINT
 
 const double EPS = 1.0e-5;
 
-void calcTangent(cv::OutputArray output, cv::InputArray input, int ksize, int maxiter) {
-    cv::Mat  gray    = input.getMat();
-    cv::Mat& tangent = output.getMatRef();
-
-    // check input arguments
-    msg_assert(gray.depth() == CV_32F && gray.channels() == 1,
-               "Input image must be single channel and floating-point-valued.");
+}  // unnamed namespace
 
-    const int width = gray.cols;
-    const int height = gray.rows;
+void calcTangent(const ImageAnalysis& analysis, cv::OutputArray output, int ksize, int maxiter, ETFKernel kernel) {
+    cv::Mat& tangent = output.getMatRef();
 
-    // detect standard edge
-    cv::Mat gx, gy;
-    cv::Sobel(gray, gx, CV_32FC1, 1, 0);
-    cv::Sobel(gray, gy, CV_32FC1, 0, 1);
+    const int width = analysis.cols();
+    const int height = analysis.rows();
 
     // compute tangent field
-    tangent = cv::Mat::zeros(height, width, CV_32FC2);
-    cv::Mat ghat = cv::Mat::zeros(height, width, CV_32FC1);
+    tangent = cv::Mat(height, width, CV_32FC2);
     double maxval = 0.0;
     for (int y = 0; y < height; y++) {
+        const float* m = analysis.magnitude().ptr<float>(y);
         for (int x = 0; x < width; x++) {
-            double vx = gx.at<float>(y, x);
-            double vy = gy.at<float>(y, x);
-            tangent.at<float>(y, x * 2 + 0) = -static_cast<float>(vy);
-            tangent.at<float>(y, x * 2 + 1) =  static_cast<float>(vx);
-            ghat.at<float>(y, x) = static_cast<float>(sqrt(vx*vx + vy*vy));
-            maxval = std::max(maxval, static_cast<double>(ghat.at<float>(y, x)));
+            maxval = std::max(maxval, static_cast<double>(m[x]));
         }
     }
-    ghat.convertTo(ghat, CV_32FC1, 1.0 / maxval);
+    cv::Mat ghat;
+    analysis.magnitude().convertTo(ghat, CV_32FC1, 1.0 / maxval);
+    parallel_for(0, height, [&](int y) {
+        const float* gx = analysis.gradX().ptr<float>(y);
+        const float* gy = analysis.gradY().ptr<float>(y);
+        float* t = tangent.ptr<float>(y);
+        for (int x = 0; x < width; x++) {
+            t[x * 2 + 0] = -gy[x];
+            t[x * 2 + 1] =  gx[x];
+        }
+    });
 
     // compute ETF
-    cv::Mat temp = cv::Mat(height, width, CV_32FC2);
+    cv::Mat temp;
     while (maxiter--) {
-        ompfor(int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                cv::Point2d sum = cv::Point2d(0.0, 0.0);
-                double weight = 0.0;
-                for (int dy = -ksize; dy <= ksize; dy++) {
-                    for (int dx = -ksize; dx <= ksize; dx++) {
-                        int xx = x + dx;
-                        int yy = y + dy;
-                        if (xx < 0 || yy < 0 || xx >= width || yy >= height) continue;
-                        if (dx * dx + dy * dy > ksize * ksize) continue;
-
-                        double vx = tangent.at<float>(y, x * 2 + 0);
-                        double vy = tangent.at<float>(y, x * 2 + 1);
-                        cv::Point2d tx = cv::Point2d(vx, vy);
-
-                        double ux = tangent.at<float>(yy, xx * 2 + 0);
-                        double uy = tangent.at<float>(yy, xx * 2 + 1);
-                        cv::Point2d ty = cv::Point2d(ux, uy);
-                        double wd = tx.dot(ty);
-
-                        double gx = ghat.at<float>(y, x);
-                        double gy = ghat.at<float>(yy, xx);
-                        double wm = (gy - gx + 1.0) / 2.0;
-
-                        sum = sum + ty * (wm * wd);
-                        weight += wm * wd;
-                    }
-                }
-
-                cv::Point2d v = weight != 0.0 ? cv::Point2d(sum.x / weight, sum.y / weight) : cv::Point2d(0.0, 0.0);
-                temp.at<float>(y, x * 2 + 0) = static_cast<float>(v.x);
-                temp.at<float>(y, x * 2 + 1) = static_cast<float>(v.y);
-            }
-        }
+        smoothETF(tangent, ghat, &temp, ksize, kernel);
 
-        temp.convertTo(tangent, CV_32FC2);
-        for (int y = 0; y < height; y++) {
+        temp.copyTo(tangent);
+        parallel_for(0, height, [&](int y) {
+            const float* t = tangent.ptr<float>(y);
+            float* g = ghat.ptr<float>(y);
             for (int x = 0; x < width; x++) {
-                double vx = tangent.at<float>(y, x * 2 + 0);
-                double vy = tangent.at<float>(y, x * 2 + 1);
-                ghat.at<float>(y, x) = static_cast<float>(sqrt(vx*vx + vy*vy));
+                double vx = t[x * 2 + 0];
+                double vy = t[x * 2 + 1];
+                g[x] = static_cast<float>(sqrt(vx*vx + vy*vy));
             }
-        }
+        });
     }
 }
 
-}  // unnamed namespace
+void calcTangent(cv::InputArray input, cv::OutputArray output, int ksize, int maxiter, ETFKernel kernel) {
+    cv::Mat gray = input.getMat();
 
+    // check input arguments
+    msg_assert(gray.depth() == CV_32F && gray.channels() == 1,
+               "Input image must be single channel and floating-point-valued.");
+
+    calcTangent(ImageAnalysis(gray, EDGE_SOBEL), output, ksize, maxiter, kernel);
+}
 
 void kuwaharaFilter(cv::InputArray input, cv::OutputArray output, int ksize) {
     cv::Mat  img = input.getMat();
@@ -210,7 +184,7 @@ void generalKF(cv::InputArray input, cv::OutputArray output, int n_div, int ksiz
 
     out = cv::Mat::ones(height, width, CV_MAKETYPE(CV_32F, dim));
     for (int c = 0; c < dim; c++) {
-        ompfor(int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](int y) {
             for (int x = 0; x < width; x++) {
                 std::vector<double> sum(n_div, 0.0);
                 std::vector<double> var(n_div, 0.0);
@@ -255,7 +229,7 @@ void generalKF(cv::InputArray input, cv::OutputArray output, int n_div, int ksiz
                 val = val > 1.0 ? 1.0 : val;
                 out.at<float>(y, x*dim + c) = static_cast<float>(val);
             }
-        }
+        });
     }
 }
 
@@ -270,46 +244,35 @@ void anisoKF(cv::InputArray input, cv::OutputArray output, int n_div, int ksize)
     double q = 3.0;
     double alpha = 1.0;
 
-    cv::Mat sst;
-    npr::calcSST(img, sst);
+    TensorField sst;
+    calcStructureTensor(img, &sst);
 
-    cv::Mat A = cv::Mat(height, width, CV_64FC1);
-    cv::Mat R = cv::Mat(height, width, CV_64FC1);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            double E = sst.at<float>(y, x * 3 + 0);
-            double F = sst.at<float>(y, x * 3 + 1);
-            double G = sst.at<float>(y, x * 3 + 2);
-            double D = sqrt((E - G) * (E - G) + 4.0 * F * F);
-
-            double lambda1 = (E + G + D) / 2.0;
-            double lambda2 = (E + G - D) / 2.0;
-            A.at<double>(y, x) = (lambda1 - lambda2) / (lambda1 + lambda2);
-            R.at<double>(y, x) = atan2(-F, lambda1 - E);
-        }
-    }
+    cv::Mat A, R;
+    sst.analyze(cv::noArray(), cv::noArray(), R, A);
 
     out = cv::Mat(height, width, CV_MAKETYPE(CV_32F, dim));
     cv::Mat temp;
     img.convertTo(temp, CV_32FC3);
     for (int c = 0; c < dim; c++) {
-        ompfor(int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](int y) {
             for (int x = 0; x < width; x++) {
                 std::vector<double> sum(n_div, 0.0f);
                 std::vector<double> var(n_div, 0.0f);
                 std::vector<double> weight(n_div, 0);
 
-                double aniso = A.at<double>(y, x);
+                double aniso = A.at<float>(y, x);
                 double sx = alpha / (aniso + alpha);
                 double sy = (alpha + aniso) / alpha;
-                double theta = -R.at<double>(y, x);
+                double theta = -R.at<float>(y, x);
+                const double cost = cos(theta);
+                const double sint = sin(theta);
 
                 for (int dy = -ksize; dy <= ksize; dy++) {
                     for (int dx = -ksize; dx <= ksize; dx++) {
                         if (dx == 0 && dy == 0) continue;
 
-                        int dx2 = static_cast<int>(sx * (cos(theta) * dx - sin(theta) * dy));
-                        int dy2 = static_cast<int>(sy * (sin(theta) * dx + cos(theta) * dy));
+                        int dx2 = static_cast<int>(sx * (cost * dx - sint * dy));
+                        int dy2 = static_cast<int>(sy * (sint * dx + cost * dy));
                         int xx = x + dx2;
                         int yy = y + dy2;
                         if (xx >= 0 && yy >= 0 && xx < width && yy < height) {
@@ -343,7 +306,7 @@ void anisoKF(cv::InputArray input, cv::OutputArray output, int n_div, int ksize)
                 val = val > 1.0 ? 1.0 : val;
                 out.at<float>(y, x*dim + c) = static_cast<float>(val);
             }
-        }
+        });
     }
 }
 
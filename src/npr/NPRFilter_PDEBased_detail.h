@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SRC_NPR_NPRFILTER_PDEBASED_DETAIL_H_
 
 #include "../core/Point.hpp"
+#include "../core/Profile.h"
 
 namespace lime {
 
@@ -61,9 +62,13 @@ double meanCurve(const cv::Mat& img, int x, int y, int c) {
 }  // unnamed namespace
 
 void solveAD(cv::InputArray input, cv::OutputArray output, double lambda, int maxiter) {
+    LIME_PROFILE_SCOPE("solveAD");
     cv::Mat  img = input.getMat();
     cv::Mat& out = output.getMatRef();
 
+    LIME_PROFILE_COUNT("pixels", img.rows * img.cols);
+    LIME_PROFILE_COUNT("iterations", maxiter);
+
     const int width = img.cols;
     const int height = img.rows;
     const int dim = img.channels();
@@ -99,9 +104,12 @@ void solveAD(cv::InputArray input, cv::OutputArray output, double lambda, int ma
 }
 
 void solveSF(cv::InputArray input, cv::OutputArray output, double lambda, int maxiter) {
+    LIME_PROFILE_SCOPE("solveSF");
     cv::Mat  img = input.getMat();
     cv::Mat& out = output.getMatRef();
 
+    LIME_PROFILE_COUNT("pixels", img.rows * img.cols);
+    LIME_PROFILE_COUNT("iterations", maxiter);
 
     const int width = img.cols;
     const int height = img.rows;
@@ -153,9 +161,13 @@ void solveSF(cv::InputArray input, cv::OutputArray output, double lambda, int ma
 }
 
 void solveMCF(cv::InputArray input, cv::OutputArray output, double lambda, int maxiter) {
+    LIME_PROFILE_SCOPE("solveMCF");
     cv::Mat  img = input.getMat();
     cv::Mat& out = output.getMatRef();
 
+    LIME_PROFILE_COUNT("pixels", img.rows * img.cols);
+    LIME_PROFILE_COUNT("iterations", maxiter);
+
     const int width = img.cols;
     const int height = img.rows;
     const int dim = img.channels();
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <opencv2/opencv.hpp>
 
+#include "VectorField.h"
+
 namespace lime {
 
 namespace npr {
@@ -69,8 +71,13 @@ inline void generalKF(cv::InputArray img, cv::OutputArray out, int n_div, int ks
 // anisotropic kuwahara filter
 inline void anisoKF(cv::InputArray img, cv::OutputArray out, int n_div, int ksize);
 
-// compute tangent field
-inline void calcTangent(cv::InputArray img, cv::OutputArray out, int ksize, int maxiter);
+// compute tangent field (ETF with the disk or separable kernel)
+inline void calcTangent(cv::InputArray img, cv::OutputArray out, int ksize, int maxiter,
+                        ETFKernel kernel = ETF_KERNEL_DISK);
+
+// compute tangent field from the gradients already computed
+inline void calcTangent(const ImageAnalysis& analysis, cv::OutputArray out, int ksize, int maxiter,
+                        ETFKernel kernel = ETF_KERNEL_DISK);
 
 }  // namespace filter
 
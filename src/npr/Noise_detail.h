@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SRC_NPR_NOISE_DETAIL_H_
 
 #include "../core/Random.h"
+#include "../core/Parallel.h"
 
 namespace lime {
 
@@ -31,35 +32,30 @@ namespace npr {
 namespace noise {
 
     void random(cv::OutputArray noise, const cv::Size& size) {
-        Random rand = Random::getRNG();
+        // each row is filled by its own stream, so the result does not depend on the number of threads
+        const Random base = Random::getRNG().split();
         cv::Mat& out = noise.getMatRef();
-        out = cv::Mat::zeros(size, CV_32FC1);
-        for (int y = 0; y < size.height; y++) {
-            for (int x = 0; x < size.width; x++) {
-                out.at<float>(y, x) = static_cast<float>(rand.randReal());
-            }
-        }
+        out.create(size, CV_32FC1);
+        parallel_for(0, size.height, [&](int y) {
+            base.stream(y).fill(out.ptr<float>(y), size.width);
+        });
     }
 
     void perlin(cv::OutputArray noise, const cv::Size& size, int level) {
         const int width = size.width;
         const int height = size.height;
-        cv::Mat out = noise.getMatRef();
+        cv::Mat& out = noise.getMatRef();
         out = cv::Mat::zeros(height, width, CV_32FC1);
 
         int scaleW = width >> level;
         int scaleH = height >> level;
         msg_assert(scaleW != 0 && scaleH != 0, "Specified level is too large.");
 
-        Random rand = Random::getRNG();
+        Random& rand = Random::getRNG();
         int count = 0;
         while (scaleW <= width && scaleH <= height) {
             cv::Mat lev = cv::Mat(scaleH, scaleW, CV_32FC1);
-            for (int y = 0; y < scaleH; y++) {
-                for (int x = 0; x < scaleW; x++) {
-                    lev.at<float>(y, x) = static_cast<float>(rand.randReal());
-                }
-            }
+            rand.fill(lev.ptr<float>(0), scaleW * scaleH);
 
             cv::resize(lev, lev, size);
             cv::GaussianBlur(lev, lev, cv::Size(5, 5), 3.0);
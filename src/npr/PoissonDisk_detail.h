@@ -26,7 +26,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 
 #include "../core/common.hpp"
+#include "../core/Parallel.h"
+#include "../core/Profile.h"
 #include "../core/Grid.hpp"
+#include "../core/Random.h"
 #include "../core/random_queue.h"
 
 namespace lime {
@@ -35,48 +38,15 @@ namespace npr {
 
 namespace {  // NOLINT
 
-cv::Point2f coord2Grid(const cv::Point2f& v, double cellSize) {
-    cv::Point2f ret;
-    ret.x = static_cast<float>(v.x / cellSize);
-    ret.y = static_cast<float>(v.y / cellSize);
-    return ret;
-}
-
-cv::Point2f generateRandomPointAround(const cv::Point2f& v, double min_dist) {
-    double radius = (1.0 + genrand_real1()) * min_dist;
-    double angle = 2.0 * PI * genrand_real1();
+cv::Point2f generateRandomPointAround(const cv::Point2f& v, double min_dist, const Random& rand) {
+    double radius = (1.0 + rand.randReal()) * min_dist;
+    double angle = 2.0 * PI * rand.randReal();
     cv::Point2f ret;
     ret.x = v.x + static_cast<int>(radius * cos(angle));
     ret.y = v.y + static_cast<int>(radius * sin(angle));
     return ret;
 }
 
-bool inNeighborhoodForList(const Grid<cv::Point2f>& grid, cv::Point2f point, double min_dist, double cellSize) {
-    cv::Point2f gridCoord = coord2Grid(point, cellSize);
-    int gridW = grid.cols();
-    int gridH = grid.rows();
-    for (int dy = -2; dy <= 2; dy++) {
-        for (int dx = -2; dx <= 2; dx++) {
-            int xx = static_cast<int>(gridCoord.x + dx);
-            int yy = static_cast<int>(gridCoord.y + dy);
-            if (grid.hasCell(yy, xx)) {
-                const std::vector<cv::Point2f>& v = grid(yy, xx);
-                if (!v.empty()) {
-                    for (int i = 0; i < v.size(); i++) {
-                        double deltaX = point.x - v[i].x;
-                        double deltaY = point.y - v[i].y;
-                        double dist = sqrt(deltaX * deltaX + deltaY * deltaY);
-                        if (dist < min_dist) {
-                            return true;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return false;
-}
-
 double minDistFromIntensity(cv::Point2f p, const cv::Mat& gray, double min_radius, double max_radius) {
     const int px = static_cast<int>(p.x);
     const int py = static_cast<int>(p.y);
@@ -94,38 +64,30 @@ void pdsRandomQueue(std::vector<cv::Point2f>* points, const cv::Mat& grayImage,
     const int width  = grayImage.cols;
     const int height = grayImage.rows;
     const int dim    = grayImage.channels();
-    double cellSize  = std::max(width, height) / 15.0;
 
-    Random rand = Random::getRNG();
+    Random& rand = Random::getRNG();
 
-    cv::Point2f gridCoord;
+    // a query of radius min_dist (<= max_radius) overlaps at most 3x3 cells
+    const double cellSize = max_radius;
     int new_point_count = 8;
     int gridW = static_cast<int>(ceil(width / cellSize));
     int gridH = static_cast<int>(ceil(height / cellSize));
-    Grid<cv::Point2f> grid(gridH, gridW);
+    Grid<cv::Point2f> grid(gridH, gridW, cellSize);
     lime::random_queue<cv::Point2f> process;
 
     if (points->empty()) {
         cv::Point2f firstPoint = cv::Point2f(rand.randInt(width), rand.randInt(height));
         process.push(firstPoint);
         points->push_back(firstPoint);
-        gridCoord = coord2Grid(firstPoint, cellSize);
-
-        const int gx = static_cast<int>(gridCoord.x);
-        const int gy = static_cast<int>(gridCoord.y);
-        grid.pushAt(gy, gx, firstPoint);
+        grid.push(firstPoint);
     } else {
         for (int i = 0; i < points->size(); i++) {
             cv::Point2f p = points->at(i);
             double min_dist = minDistFromIntensity(p, grayImage, min_radius, max_radius);
             if (p.x >= 0 && p.y >= 0 && p.x < width && p.y < height) {
-                if (!inNeighborhoodForList(grid, p, min_dist, cellSize)) {
+                if (!grid.containsWithin(p, min_dist)) {
                     process.push(p);
-                    gridCoord = coord2Grid(p, cellSize);
-
-                    const int gx = static_cast<int>(gridCoord.x);
-                    const int gy = static_cast<int>(gridCoord.y);
-                    grid.pushAt(gy, gx, p);
+                    grid.push(p);
                 } else {
                     points->erase(points->begin() + i);
                     i--;
@@ -138,16 +100,12 @@ void pdsRandomQueue(std::vector<cv::Point2f>* points, const cv::Mat& grayImage,
         cv::Point2f p = process.pop();
         for (int i = 0; i < new_point_count; i++) {
             double min_dist = minDistFromIntensity(p, grayImage, min_radius, max_radius);
-            cv::Point2f q = generateRandomPointAround(p, min_dist);
+            cv::Point2f q = generateRandomPointAround(p, min_dist, rand);
             if (q.x >= 0 && q.y >= 0 && q.x < width && q.y < height) {
-                if (!inNeighborhoodForList(grid, q, min_dist, cellSize)) {
+                if (!grid.containsWithin(q, min_dist)) {
                     process.push(q);
                     points->push_back(q);
-                    gridCoord = coord2Grid(q, cellSize);
-
-                    const int gx = static_cast<int>(gridCoord.x);
-                    const int gy = static_cast<int>(gridCoord.y);
-                    grid.pushAt(gy, gx, q);
+                    grid.push(q);
                 }
             }
         }
@@ -185,13 +143,13 @@ bool isConflict(const cv::Mat& gray, const cv::Mat& noise, cv::Point2f p, double
 }
 
 bool throwSample(const cv::Mat& gray, const cv::Mat& noise, cv::Point2f* newPoint,
-                 int nTrial, const cv::Rect& region, double min_radius, double max_radius) {
+                 int nTrial, const cv::Rect& region, double min_radius, double max_radius, const Random& rand) {
     const int width  = gray.cols;
     const int height = gray.rows;
 
     for (int t = 0; t < nTrial; t++) {
-        int rx = region.x + genrand_int31() % region.width;
-        int ry = region.y + genrand_int31() % region.height;
+        int rx = region.x + rand.randInt(region.width);
+        int ry = region.y + rand.randInt(region.height);
         if (rx >= 0 && ry >= 0 && rx < width && ry < height) {
             cv::Point2f p = cv::Point2f(rx, ry);
             if (!isConflict(gray, noise, p, min_radius, max_radius)) {
@@ -252,52 +210,62 @@ void pdsParallel(std::vector<cv::Point2f>* points, const cv::Mat& grayImage, dou
         }
     }
 
-    // precompute
-    int nPhaseGroup = static_cast<int>(2.0 * sqrt(2.0) + 1.0);
-    int nPhaseGroup2 = nPhaseGroup * nPhaseGroup;
-    std::vector<int> order(nPhaseGroup2);
-    for (int i = 0; i < nPhaseGroup2; i++) {
-        order[i] = i;
-    }
+    // every cell draws samples from its own stream, so that the result
+    // does not depend on the number of threads
+    Random& rand = Random::getRNG();
+    const Random base = rand.split();
+    uint64_t cellOffset = 0;
 
-    // determine traverse order for phase groups
-    for (int i = 0; i < 100; i++) {
-        int p = genrand_int31() % nPhaseGroup2;
-        int q = genrand_int31() % nPhaseGroup2;
-        int t = order[p];
-        order[p] = order[q];
-        order[q] = t;
-    }
+    // isConflict reads the noise within this distance from a sample
+    const int reach = static_cast<int>(max_radius * 2.0);
 
     double limit = 2.0 * sqrt(2.0) * min_radius;
     int gridW = width;
     int gridH = height;
     while (std::min(gridW, gridH) > limit) {
-        int nGridX = width / gridW;
-        int nGridY = height / gridH;
-        int cellW = gridW / nPhaseGroup + 1;
-        int cellH = gridH / nPhaseGroup + 1;
-
-        ompfor (int gy = 0; gy < nGridY; gy++) {  // NOLINT
-            for (int gx = 0; gx < nGridX; gx++) {
-                for (int k = 0; k < nPhaseGroup2; k++) {
-                    int i = order[k];
-                    int cx = i / nPhaseGroup;
-                    int cy = i % nPhaseGroup;
-                    int sx = gx * gridW + cx * cellW;
-                    int sy = gy * gridH + cy * cellH;
-                    cv::Rect omega = cv::Rect(sx, sy, cellW, cellH);
-                    if (!containPoint(noise, omega)) {
-                        cv::Point2f p;
-                        if (throwSample(grayImage, noise, &p, 10, omega, min_radius, max_radius)) {
-                            int ipx = static_cast<int>(p.x);
-                            int ipy = static_cast<int>(p.y);
-                            noise.at<float>(ipy, ipx) = 1.0f;
-                        }
+        const int cellW = gridW / 3 + 1;
+        const int cellH = gridH / 3 + 1;
+        const int nCellX = (width + cellW - 1) / cellW;
+        const int nCellY = (height + cellH - 1) / cellH;
+
+        // Cells in the same phase group are processed in parallel. They are apart from
+        // each other by more than the reach of isConflict, so that no cell reads the
+        // pixels which another cell writes.
+        const int nPhaseX = std::max(3, (reach + cellW - 1) / cellW + 1);
+        const int nPhaseY = std::max(3, (reach + cellH - 1) / cellH + 1);
+        const int nPhases = nPhaseX * nPhaseY;
+
+        // determine traverse order for phase groups
+        std::vector<int> order(nPhases);
+        for (int i = 0; i < nPhases; i++) {
+            order[i] = i;
+        }
+        const Random orderRand = base.stream(cellOffset++);
+        for (int i = nPhases - 1; i > 0; i--) {
+            std::swap(order[i], order[orderRand.randInt(i + 1)]);
+        }
+
+        for (int k = 0; k < nPhases; k++) {
+            const int cx = order[k] % nPhaseX;
+            const int cy = order[k] / nPhaseX;
+            const int nGridX = (nCellX - cx + nPhaseX - 1) / nPhaseX;
+            const int nGridY = (nCellY - cy + nPhaseY - 1) / nPhaseY;
+            parallel_for_2d(nGridY, nGridX, [&](int gy, int gx) {
+                const int ix = gx * nPhaseX + cx;
+                const int iy = gy * nPhaseY + cy;
+                const Random cellRand = base.stream(cellOffset + static_cast<uint64_t>(iy) * nCellX + ix);
+                cv::Rect omega = cv::Rect(ix * cellW, iy * cellH, cellW, cellH);
+                if (!containPoint(noise, omega)) {
+                    cv::Point2f p;
+                    if (throwSample(grayImage, noise, &p, 10, omega, min_radius, max_radius, cellRand)) {
+                        int ipx = static_cast<int>(p.x);
+                        int ipy = static_cast<int>(p.y);
+                        noise.at<float>(ipy, ipx) = 1.0f;
                     }
                 }
-            }
+            }, 1);
         }
+        cellOffset += static_cast<uint64_t>(nCellX) * nCellY;
         gridW /= 2;
         gridH /= 2;
     }
@@ -317,6 +285,9 @@ void pdsParallel(std::vector<cv::Point2f>* points, const cv::Mat& grayImage, dou
 
 void poissonDisk(cv::InputArray grayImage, std::vector<cv::Point2f>* samplePoints,
                  PdsMethod pdsMethod, double minRadius, double maxRadius) {
+    LIME_PROFILE_SCOPE("poissonDisk");
+    LIME_PROFILE_COUNT("pixels", grayImage.rows() * grayImage.cols());
+
     switch (pdsMethod) {
     case PDS_RAND_QUEUE:
         pdsRandomQueue(samplePoints, grayImage.getMat(), minRadius, maxRadius);
@@ -329,6 +300,7 @@ void poissonDisk(cv::InputArray grayImage, std::vector<cv::Point2f>* samplePoint
     default:
         msg_assert(false, "Unknown method specified to Poisson disk sampling.");
     }
+    LIME_PROFILE_COUNT("samples", samplePoints->size());
 }
 
 }  // namespace npr
@@ -31,6 +31,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <utility>
 #include <cmath>
 
+#include "../core/common.hpp"
+#include "../core/Array2d.h"
+
 namespace lime {
 
 namespace npr {
@@ -115,15 +118,12 @@ class Tensor {
     }
 
     double& elem(int i, int j) {
-        try {
-            if (i < 0 || j < 0 || i >= 2 || j >= 2) {
-                throw "Exception: invalid element indices";
-            }
-        }
-        catch (std::string msg) {
-            std::cout << msg << std::endl;
-            return data[0];
-        }
+        msg_assert(i >= 0 && j >= 0 && i < 2 && j < 2, "Invalid element indices");
+        return data[(i << 1) + j];
+    }
+
+    double elem(int i, int j) const {
+        msg_assert(i >= 0 && j >= 0 && i < 2 && j < 2, "Invalid element indices");
         return data[(i << 1) + j];
     }
 
@@ -156,6 +156,12 @@ class Tensor {
 
 }  // namespace npr
 
+// * Array2d<Tensor> is viewed as CV_64FC4 matrix (v11, v12, v21, v22)
+template <>
+struct MatTraits<npr::Tensor> {
+    enum { type = CV_64FC4 };
+};
+
 }  // namespace lime
 
 #endif  // SRC_NPR_TESNOR_HPP_
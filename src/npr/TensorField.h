@@ -0,0 +1,106 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_TENSORFIELD_H_
+#define SRC_NPR_TENSORFIELD_H_
+
+#include <opencv2/opencv.hpp>
+
+#include "../core/Array2d.h"
+#include "Tensor.hpp"
+
+namespace lime {
+
+namespace npr {
+
+/* Field of symmetric 2x2 tensors
+ *   | E F |
+ *   | F G |
+ * stored as three float planes (structure of arrays). Each plane is an
+ * Array2d with 64-byte aligned rows, so that the batch analysis below is
+ * vectorized by the compiler.
+ */
+class TensorField {
+ public:
+    TensorField();
+
+    // * allocate a zero-valued field
+    TensorField(int rows, int cols);
+
+    /* Create a field from a matrix of interleaved tensor elements
+     * @param[in] efg: CV_32FC3 matrix with channels (E, F, G), such as a smoothed structure tensor
+     */
+    explicit TensorField(cv::InputArray efg);
+
+    // * create a field from an array of tensors
+    explicit TensorField(const Array2d<Tensor>& tensors);
+
+    int rows() const;
+
+    int cols() const;
+
+    // * row pointers of each plane
+    float* E(int y) const;
+    float* F(int y) const;
+    float* G(int y) const;
+
+    // * tensor at (y, x)
+    Tensor at(int y, int x) const;
+
+    // * interleaved CV_32FC3 matrix with channels (E, F, G)
+    cv::Mat toMat() const;
+
+    /* Analyze the eigen system of all the tensors. Any of the outputs can be cv::noArray().
+     * @param[out] lambda1: major eigenvalues (CV_32FC1)
+     * @param[out] lambda2: minor eigenvalues (CV_32FC1)
+     * @param[out] angles: orientation of the minor eigenvector, i.e., direction of the flow (CV_32FC1)
+     * @param[out] aniso: anisotropy (lambda1 - lambda2) / (lambda1 + lambda2), 0 for zero tensors (CV_32FC1)
+     */
+    void analyze(cv::OutputArray lambda1, cv::OutputArray lambda2,
+                 cv::OutputArray angles, cv::OutputArray aniso) const;
+
+    // * major and minor eigenvalues
+    void eigen(cv::OutputArray lambda1, cv::OutputArray lambda2) const;
+
+    // * orientation of the flow
+    void orientation(cv::OutputArray angles) const;
+
+    // * anisotropy
+    void anisotropy(cv::OutputArray aniso) const;
+
+    /* Unit vectors along the flow, i.e., normalized minor eigenvectors, which
+     * are computed without going through the angles. Zero tensors give (1, 0)
+     * as their angles are 0.
+     * @param[out] vectors: CV_32FC2 matrix of the tangent vectors
+     */
+    void tangent(cv::OutputArray vectors) const;
+
+ private:
+    Array2d<float> planeE, planeF, planeG;
+};  // class TensorField
+
+}  // namespace npr
+
+}  // namespace lime
+
+#include "TensorField_detail.h"
+
+#endif  // SRC_NPR_TENSORFIELD_H_
@@ -0,0 +1,244 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_TENSORFIELD_DETAIL_H_
+#define SRC_NPR_TENSORFIELD_DETAIL_H_
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "../core/common.hpp"
+#include "../core/FastMath.h"
+#include "../core/Parallel.h"
+
+namespace lime {
+
+namespace npr {
+
+namespace {  // NOLINT
+
+/* Eigen analysis of a row of tensors. The loop has no branches except
+ * for selects, so that it is vectorized.
+ */
+void analyzeTensorRow(const float* E, const float* F, const float* G, int n,
+                      float* lambda1, float* lambda2, float* aniso) {
+    for (int x = 0; x < n; x++) {
+        const float e = E[x];
+        const float f = F[x];
+        const float g = G[x];
+        const float d = std::sqrt((e - g) * (e - g) + 4.0f * f * f);
+        const float s = e + g;
+        lambda1[x] = 0.5f * (s + d);
+        lambda2[x] = 0.5f * (s - d);
+        aniso[x] = s != 0.0f ? d / s : 0.0f;
+    }
+}
+
+/* Minor eigenvector (lambda1 - E, -F), which is not normalized. lambda1 - E is
+ * computed without subtracting E from lambda1 not to lose the precision.
+ */
+void minorEigenvector(float e, float f, float g, float* ux, float* uy) {
+    const float d = std::sqrt((e - g) * (e - g) + 4.0f * f * f);
+    *ux = 0.5f * (g - e + d);
+    *uy = -f;
+}
+
+}  // unnamed namespace
+
+inline TensorField::TensorField()
+    : planeE()
+    , planeF()
+    , planeG() {
+}
+
+inline TensorField::TensorField(int rows, int cols)
+    : planeE(rows, cols, 0.0f, true)
+    , planeF(rows, cols, 0.0f, true)
+    , planeG(rows, cols, 0.0f, true) {
+}
+
+inline TensorField::TensorField(cv::InputArray efg)
+    : planeE()
+    , planeF()
+    , planeG() {
+    cv::Mat mat = efg.getMat();
+    msg_assert(mat.type() == CV_32FC3, "Tensor elements must be stored in CV_32FC3 matrix");
+
+    const int width = mat.cols;
+    const int height = mat.rows;
+    *this = TensorField(height, width);
+    parallel_for(0, height, [&](int y) {
+        const float* p = mat.ptr<float>(y);
+        float* e = E(y);
+        float* f = F(y);
+        float* g = G(y);
+        for (int x = 0; x < width; x++) {
+            e[x] = p[x * 3 + 0];
+            f[x] = p[x * 3 + 1];
+            g[x] = p[x * 3 + 2];
+        }
+    });
+}
+
+inline TensorField::TensorField(const Array2d<Tensor>& tensors)
+    : planeE(tensors.rows(), tensors.cols(), 0.0f, true)
+    , planeF(tensors.rows(), tensors.cols(), 0.0f, true)
+    , planeG(tensors.rows(), tensors.cols(), 0.0f, true) {
+    for (int y = 0; y < tensors.rows(); y++) {
+        for (int x = 0; x < tensors.cols(); x++) {
+            const Tensor& t = tensors(y, x);
+            planeE(y, x) = static_cast<float>(t.elem(0, 0));
+            planeF(y, x) = static_cast<float>(t.elem(0, 1));
+            planeG(y, x) = static_cast<float>(t.elem(1, 1));
+        }
+    }
+}
+
+inline int TensorField::rows() const {
+    return planeE.rows();
+}
+
+inline int TensorField::cols() const {
+    return planeE.cols();
+}
+
+inline float* TensorField::E(int y) const {
+    return planeE.ptr(y);
+}
+
+inline float* TensorField::F(int y) const {
+    return planeF.ptr(y);
+}
+
+inline float* TensorField::G(int y) const {
+    return planeG.ptr(y);
+}
+
+inline Tensor TensorField::at(int y, int x) const {
+    const double f = planeF(y, x);
+    return Tensor(planeE(y, x), f, f, planeG(y, x));
+}
+
+inline cv::Mat TensorField::toMat() const {
+    const int width = cols();
+    const int height = rows();
+    cv::Mat mat(height, width, CV_32FC3);
+    parallel_for(0, height, [&](int y) {
+        float* p = mat.ptr<float>(y);
+        const float* e = E(y);
+        const float* f = F(y);
+        const float* g = G(y);
+        for (int x = 0; x < width; x++) {
+            p[x * 3 + 0] = e[x];
+            p[x * 3 + 1] = f[x];
+            p[x * 3 + 2] = g[x];
+        }
+    });
+    return mat;
+}
+
+inline void TensorField::analyze(cv::OutputArray lambda1, cv::OutputArray lambda2,
+                                 cv::OutputArray angles, cv::OutputArray aniso) const {
+    const int width = cols();
+    const int height = rows();
+
+    cv::Mat l1, l2, ang, an;
+    if (lambda1.needed()) {
+        lambda1.create(height, width, CV_32FC1);
+        l1 = lambda1.getMat();
+    }
+    if (lambda2.needed()) {
+        lambda2.create(height, width, CV_32FC1);
+        l2 = lambda2.getMat();
+    }
+    if (angles.needed()) {
+        angles.create(height, width, CV_32FC1);
+        ang = angles.getMat();
+    }
+    if (aniso.needed()) {
+        aniso.create(height, width, CV_32FC1);
+        an = aniso.getMat();
+    }
+
+    parallel_for(0, height, [&](int y) {
+        std::vector<float> buffer(width * 3);
+        float* r1 = l1.empty() ? &buffer[0] : l1.ptr<float>(y);
+        float* r2 = l2.empty() ? &buffer[width] : l2.ptr<float>(y);
+        float* ra = an.empty() ? &buffer[width * 2] : an.ptr<float>(y);
+        analyzeTensorRow(E(y), F(y), G(y), width, r1, r2, ra);
+
+        if (!ang.empty()) {
+            const float* e = E(y);
+            const float* f = F(y);
+            const float* g = G(y);
+            float* out = ang.ptr<float>(y);
+            for (int x = 0; x < width; x++) {
+                float ux, uy;
+                minorEigenvector(e[x], f[x], g[x], &ux, &uy);
+                out[x] = fastAtan2(uy, ux);
+            }
+        }
+    });
+}
+
+inline void TensorField::eigen(cv::OutputArray lambda1, cv::OutputArray lambda2) const {
+    analyze(lambda1, lambda2, cv::noArray(), cv::noArray());
+}
+
+inline void TensorField::orientation(cv::OutputArray angles) const {
+    analyze(cv::noArray(), cv::noArray(), angles, cv::noArray());
+}
+
+inline void TensorField::anisotropy(cv::OutputArray aniso) const {
+    analyze(cv::noArray(), cv::noArray(), cv::noArray(), aniso);
+}
+
+inline void TensorField::tangent(cv::OutputArray vectors) const {
+    const int width = cols();
+    const int height = rows();
+    vectors.create(height, width, CV_32FC2);
+    cv::Mat V = vectors.getMat();
+
+    parallel_for(0, height, [&](int y) {
+        const float* e = E(y);
+        const float* f = F(y);
+        const float* g = G(y);
+        float* v = V.ptr<float>(y);
+        for (int x = 0; x < width; x++) {
+            // * the eigenvector is divided by its larger element first not to underflow
+            float ux, uy;
+            minorEigenvector(e[x], f[x], g[x], &ux, &uy);
+            const float m = std::max(std::abs(ux), std::abs(uy));
+            const float tx = ux / (m > 0.0f ? m : 1.0f);
+            const float ty = uy / (m > 0.0f ? m : 1.0f);
+            const float inv = 1.0f / std::sqrt(m > 0.0f ? tx * tx + ty * ty : 1.0f);
+            v[x * 2 + 0] = m > 0.0f ? tx * inv : 1.0f;
+            v[x * 2 + 1] = ty * inv;
+        }
+    });
+}
+
+}  // namespace npr
+
+}  // namespace lime
+
+#endif  // SRC_NPR_TENSORFIELD_DETAIL_H_
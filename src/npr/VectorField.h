@@ -29,6 +29,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../core/Point.hpp"
 #include "../core/Array2d.h"
 #include "Tensor.hpp"
+#include "TensorField.h"
+#include "ImageAnalysis.h"
 #include "Singularity.hpp"
 
 namespace lime {
@@ -37,25 +39,89 @@ namespace npr {
 
 enum VFieldType {
     VECTOR_SST,
-    VECTOR_ETF
+    VECTOR_ETF,
+    VECTOR_ETF_SEPARABLE
 };
 
-enum EdgeDetector {
-    EDGE_SOBEL,
-    EDGE_ROTATIONAL
+// * format of the output of calcVectorField
+enum VFieldOutput {
+    VFIELD_ANGLES,   // * tangent directions (CV_32FC1)
+    VFIELD_VECTORS   // * unit tangent vectors (CV_32FC2), computed without trigonometric functions
+};
+
+// * neighborhood of edge tangent flow (ETF) smoothing
+enum ETFKernel {
+    ETF_KERNEL_DISK,       // * disk of radius ksize
+    ETF_KERNEL_SEPARABLE   // * horizontal and then vertical lines of length 2 * ksize + 1
 };
 
 /* Compute vector field
  * @param[in] img: input image from which a vector field is computed
  * @param[out] angles: output array of CV_32FC1 depth which stores tangent direction of vectors
+ *                     (or unit tangent vectors of CV_32FC2 depth for VFIELD_VECTORS)
  * @param[in] ksize: kernel size for smoothing the vector field
- * @param[in] vfieldType: algorithm to detect vector field (SST or ETF)
+ * @param[in] vfieldType: algorithm to detect vector field (SST, ETF or separable ETF)
  * @param[in] edgeDetector: edge detection algorithm
+ * @param[in] output: format of the output (angles or vectors)
  */
 inline void calcVectorField(cv::InputArray input, cv::OutputArray angles, int ksize = 5,
-                            VFieldType vfieldType = VECTOR_SST, EdgeDetector edgeDetector = EDGE_SOBEL);
+                            VFieldType vfieldType = VECTOR_SST, EdgeDetector edgeDetector = EDGE_SOBEL,
+                            VFieldOutput output = VFIELD_ANGLES);
+
+/* Compute vector field from the gradients already computed
+ * @param[in] analysis: gray image and gradients of the input image
+ * @param[out] angles: output array of CV_32FC1 depth which stores tangent direction of vectors
+ *                     (or unit tangent vectors of CV_32FC2 depth for VFIELD_VECTORS)
+ * @param[in] ksize: kernel size for smoothing the vector field
+ * @param[in] vfieldType: algorithm to detect vector field (SST, ETF or separable ETF)
+ * @param[in] output: format of the output (angles or vectors)
+ */
+inline void calcVectorField(const ImageAnalysis& analysis, cv::OutputArray angles, int ksize = 5,
+                            VFieldType vfieldType = VECTOR_SST, VFieldOutput output = VFIELD_ANGLES);
+
+/* Compute vector field on an image pyramid. The field is estimated on the
+ * downsampled image with the kernel size scaled accordingly, upsampled with
+ * the input image as the guide of joint bilateral interpolation, and then
+ * refined with the full-resolution gradients only at anisotropic pixels.
+ * @param[in] img: input image from which a vector field is computed
+ * @param[out] angles: output array of CV_32FC1 depth which stores tangent direction of vectors
+ * @param[in] ksize: kernel size for smoothing the vector field at full resolution
+ * @param[in] vfieldType: algorithm to detect vector field (SST, ETF or separable ETF)
+ * @param[in] edgeDetector: edge detection algorithm
+ * @param[in] levels: number of downsampling steps by half (negative chooses it from ksize)
+ * @param[in] output: format of the output (angles or vectors)
+ */
+inline void calcVectorFieldPyramid(cv::InputArray input, cv::OutputArray angles, int ksize = 21,
+                                   VFieldType vfieldType = VECTOR_SST, EdgeDetector edgeDetector = EDGE_SOBEL,
+                                   int levels = -1, VFieldOutput output = VFIELD_ANGLES);
+
+/* Compute smoothed structure tensor field
+ * @param[in] input: input image
+ * @param[out] field: structure tensors
+ * @param[in] ksize: kernel size for smoothing the tensors
+ * @param[in] edgeDetector: edge detection algorithm
+ */
+inline void calcStructureTensor(cv::InputArray input, TensorField* field, int ksize = 5,
+                                EdgeDetector edgeDetector = EDGE_SOBEL);
+
+// * compute smoothed structure tensor field from the gradients already computed
+inline void calcStructureTensor(const ImageAnalysis& analysis, TensorField* field, int ksize = 5);
+
+/* Detect singularity of vector field. Zeros of (E - G, F) are searched in the
+ * two triangles of every pixel quad, and classified into wedges and trisectors.
+ * @param[in] sst: smoothed structure tensors
+ * @param[out] points: singular points sorted in the raster order
+ */
+inline void detectSingular(const TensorField& sst, std::vector<SingularPoint>* points);
 
 // * detect singularity of vector field
+inline void detectSingular(const Array2d<Tensor>& sst, std::vector<SingularPoint>* points);
+
+// * detect singularity of vector field ("delauneyNodes" is ignored and left unchanged)
+inline void detectSingular(const TensorField& sst, std::vector<SingularPoint>* points,
+                           std::vector<cv::Point2f>* delauneyNodes);
+
+// * detect singularity of vector field ("delauneyNodes" is ignored and left unchanged)
 inline void detectSingular(const Array2d<Tensor>& sst, std::vector<SingularPoint>* points,
                            std::vector<cv::Point2f>* delauneyNodes);
 
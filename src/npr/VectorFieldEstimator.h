@@ -0,0 +1,85 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_VECTORFIELDESTIMATOR_H_
+#define SRC_NPR_VECTORFIELDESTIMATOR_H_
+
+#include <opencv2/opencv.hpp>
+
+#include "TensorField.h"
+#include "VectorField.h"
+
+namespace lime {
+
+namespace npr {
+
+/* Vector field estimator for interactive editing. It keeps the intermediate
+ * results of the smoothed structure tensor (gray image, gradient tensors,
+ * relaxed tensors and smoothed tensors), so that only the region affected
+ * by an edit is recomputed when a part of the image is changed. The outputs
+ * are the same as those of calcVectorField with VECTOR_SST.
+ */
+class VectorFieldEstimator {
+ public:
+    /* Constructor
+     * @param[in] ksize: kernel size for smoothing the vector field
+     * @param[in] edgeDetector: edge detection algorithm
+     */
+    explicit VectorFieldEstimator(int ksize = 5, EdgeDetector edgeDetector = EDGE_SOBEL);
+
+    // * compute the vector field of the whole image
+    void compute(cv::InputArray image);
+
+    /* Recompute the vector field after the pixels in the dirty region are changed.
+     * The outputs are updated in place.
+     * @param[in] image: whole image after the change, whose size is the same as the last one
+     * @param[in] dirty: region of the changed pixels
+     * @return region of the outputs which are updated
+     */
+    cv::Rect update(cv::InputArray image, const cv::Rect& dirty);
+
+    // * number of pixels around a dirty region which are affected by the change
+    int footprint() const;
+
+    // * smoothed structure tensors
+    const TensorField& tensors() const;
+
+    // * tangent direction of vectors (CV_32FC1)
+    const cv::Mat& angles() const;
+
+    // * unit tangent vectors (CV_32FC2)
+    const cv::Mat& vectors() const;
+
+ private:
+    int ksize;
+    EdgeDetector edgeDetector;
+    cv::Mat gray;
+    TensorField gradient, relaxed, smoothed;
+    cv::Mat angleMap, vectorMap;
+};  // class VectorFieldEstimator
+
+}  // namespace npr
+
+}  // namespace lime
+
+#include "VectorFieldEstimator_detail.h"
+
+#endif  // SRC_NPR_VECTORFIELDESTIMATOR_H_
@@ -0,0 +1,170 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef SRC_NPR_VECTORFIELDESTIMATOR_DETAIL_H_
+#define SRC_NPR_VECTORFIELDESTIMATOR_DETAIL_H_
+
+#include <cmath>
+#include <cstring>
+
+#include "../core/common.hpp"
+#include "../core/Parallel.h"
+#include "../core/Profile.h"
+
+namespace lime {
+
+namespace npr {
+
+namespace {  // NOLINT
+
+// * rectangle expanded by the margin and clipped by the image size
+cv::Rect expandRect(const cv::Rect& rect, int margin, const cv::Size& size) {
+    cv::Rect expanded(rect.x - margin, rect.y - margin, rect.width + 2 * margin, rect.height + 2 * margin);
+    return expanded & cv::Rect(0, 0, size.width, size.height);
+}
+
+// * copy the tensors in "rect" of "src" to a new field
+TensorField cropTensor(const TensorField& src, const cv::Rect& rect) {
+    TensorField dst(rect.height, rect.width);
+    parallel_for(0, rect.height, [&](int y) {
+        memcpy(dst.E(y), src.E(rect.y + y) + rect.x, sizeof(float) * rect.width);
+        memcpy(dst.F(y), src.F(rect.y + y) + rect.x, sizeof(float) * rect.width);
+        memcpy(dst.G(y), src.G(rect.y + y) + rect.x, sizeof(float) * rect.width);
+    });
+    return dst;
+}
+
+// * copy the tensors in "rect" of "src" to "dst" at "pos"
+void pasteTensor(const TensorField& src, const cv::Rect& rect, TensorField* dst, const cv::Point& pos) {
+    parallel_for(0, rect.height, [&](int y) {
+        memcpy(dst->E(pos.y + y) + pos.x, src.E(rect.y + y) + rect.x, sizeof(float) * rect.width);
+        memcpy(dst->F(pos.y + y) + pos.x, src.F(rect.y + y) + rect.x, sizeof(float) * rect.width);
+        memcpy(dst->G(pos.y + y) + pos.x, src.G(rect.y + y) + rect.x, sizeof(float) * rect.width);
+    });
+}
+
+}  // unnamed namespace
+
+inline VectorFieldEstimator::VectorFieldEstimator(int ksize, EdgeDetector edgeDetector)
+    : ksize(ksize)
+    , edgeDetector(edgeDetector)
+    , gray()
+    , gradient()
+    , relaxed()
+    , smoothed()
+    , angleMap()
+    , vectorMap() {
+}
+
+inline void VectorFieldEstimator::compute(cv::InputArray image) {
+    const int width = image.cols();
+    const int height = image.rows();
+
+    gray = cv::Mat(height, width, CV_32FC1);
+    gradient = TensorField(height, width);
+    relaxed = TensorField(height, width);
+    smoothed = TensorField(height, width);
+    angleMap = cv::Mat(height, width, CV_32FC1);
+    vectorMap = cv::Mat(height, width, CV_32FC2);
+    update(image, cv::Rect(0, 0, width, height));
+}
+
+inline cv::Rect VectorFieldEstimator::update(cv::InputArray input, const cv::Rect& dirty) {
+    LIME_PROFILE_SCOPE("VectorFieldEstimator::update");
+    cv::Mat image = input.getMat();
+    msg_assert(image.size() == gray.size(), "Image size must be the same as that of the last compute.");
+
+    const cv::Size size = image.size();
+    const cv::Rect region = dirty & cv::Rect(0, 0, size.width, size.height);
+    LIME_PROFILE_COUNT("pixels", region.area());
+    if (region.area() == 0) return region;
+
+    // Each stage changes the pixels within its reach around the region updated by
+    // the previous stage. The stage is computed on a crop including the inputs
+    // within its reach again, and the crop borders which are not the image borders
+    // only affect the pixels outside the updated region.
+    grayImage32F(image(region)).copyTo(gray(region));
+
+    // 3x3 gradients
+    const cv::Rect gradRect = expandRect(region, 1, size);
+    {
+        const cv::Rect inRect = expandRect(gradRect, 1, size);
+        TensorField temp;
+        calcGradientTensor(ImageAnalysis(gray(inRect), edgeDetector), &temp);
+        pasteTensor(temp, gradRect - inRect.tl(), &gradient, gradRect.tl());
+    }
+
+    // tensor relaxation
+    const cv::Rect relaxRect = expandRect(gradRect, SST_RELAX_ITERATIONS, size);
+    {
+        const cv::Rect inRect = expandRect(relaxRect, SST_RELAX_ITERATIONS, size);
+        TensorField temp = cropTensor(gradient, inRect);
+        relaxTensor(&temp, SST_RELAX_ITERATIONS, SST_RELAX_THRESHOLD);
+        pasteTensor(temp, relaxRect - inRect.tl(), &relaxed, relaxRect.tl());
+    }
+
+    // smoothing
+    const int radius = ksize / 2;
+    const cv::Rect smoothRect = expandRect(relaxRect, radius, size);
+    {
+        const cv::Rect inRect = expandRect(smoothRect, radius, size);
+        TensorField temp = cropTensor(relaxed, inRect);
+        boxFilterRows([&](int y) { return temp.E(y); }, inRect.width, inRect.height, radius);
+        boxFilterRows([&](int y) { return temp.F(y); }, inRect.width, inRect.height, radius);
+        boxFilterRows([&](int y) { return temp.G(y); }, inRect.width, inRect.height, radius);
+        pasteTensor(temp, smoothRect - inRect.tl(), &smoothed, smoothRect.tl());
+    }
+
+    // outputs
+    cv::Mat theta, tangent;
+    const TensorField updated = cropTensor(smoothed, smoothRect);
+    updated.orientation(theta);
+    updated.tangent(tangent);
+    parallel_for(0, smoothRect.height, [&](int y) {
+        memcpy(angleMap.ptr<float>(smoothRect.y + y) + smoothRect.x, theta.ptr<float>(y),
+               sizeof(float) * smoothRect.width);
+        memcpy(vectorMap.ptr<float>(smoothRect.y + y) + smoothRect.x * 2, tangent.ptr<float>(y),
+               sizeof(float) * smoothRect.width * 2);
+    });
+    return smoothRect;
+}
+
+inline int VectorFieldEstimator::footprint() const {
+    return 1 + SST_RELAX_ITERATIONS + ksize / 2;
+}
+
+inline const TensorField& VectorFieldEstimator::tensors() const {
+    return smoothed;
+}
+
+inline const cv::Mat& VectorFieldEstimator::angles() const {
+    return angleMap;
+}
+
+inline const cv::Mat& VectorFieldEstimator::vectors() const {
+    return vectorMap;
+}
+
+}  // namespace npr
+
+}  // namespace lime
+
+#endif  // SRC_NPR_VECTORFIELDESTIMATOR_DETAIL_H_
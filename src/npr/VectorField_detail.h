@@ -22,9 +22,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_NPR_VECTORFIELD_DETAIL_H_
 #define SRC_NPR_VECTORFIELD_DETAIL_H_
 
+#include <cmath>
+#include <cstring>
 #include <vector>
+#include <algorithm>
 
-#include "PoissonDisk.h"
+#include "../core/FastMath.h"
+#include "../core/Parallel.h"
+#include "../core/Profile.h"
 
 namespace lime {
 
@@ -32,361 +37,676 @@ namespace npr {
 
 namespace {  // NOLINT
 
-void calcETF(cv::InputArray input, cv::OutputArray output,
-             int ksize = 5, int maxiter = 3, EdgeDetector edgeDetector = EDGE_SOBEL) {
-    cv::Mat  image = input.getMat();
-    cv::Mat& etf   = output.getMatRef();
+// * iterations and energy threshold of the tensor relaxation in SST
+const int SST_RELAX_ITERATIONS = 5;
+const float SST_RELAX_THRESHOLD = 0.002f;
+
+// * iterations of ETF smoothing in calcVectorField
+const int ETF_ITERATIONS = 3;
+
+/* One step of edge tangent flow smoothing over the given neighbors. The
+ * tangent and gradient magnitude of the center pixel are loaded once, and
+ * interior pixels skip the bounds checks of the neighbors.
+ * @param[in] tangent: tangent vectors (CV_32FC2)
+ * @param[in] ghat: gradient magnitude (CV_32FC1)
+ * @param[in] offsets: offsets of the neighbors
+ * @param[out] result: weighted average of the neighboring tangents (CV_32FC2)
+ */
+void smoothETFStep(const cv::Mat& tangent, const cv::Mat& ghat, const std::vector<cv::Point>& offsets,
+                   cv::Mat* result) {
+    const int width = tangent.cols;
+    const int height = tangent.rows;
+    const int nOffsets = static_cast<int>(offsets.size());
+
+    int reachX = 0;
+    int reachY = 0;
+    std::vector<int> tOffsets(nOffsets), gOffsets(nOffsets);
+    const int tStep = static_cast<int>(tangent.step[0] / sizeof(float));
+    const int gStep = static_cast<int>(ghat.step[0] / sizeof(float));
+    for (int i = 0; i < nOffsets; i++) {
+        reachX = std::max(reachX, std::abs(offsets[i].x));
+        reachY = std::max(reachY, std::abs(offsets[i].y));
+        tOffsets[i] = offsets[i].y * tStep + offsets[i].x * 2;
+        gOffsets[i] = offsets[i].y * gStep + offsets[i].x;
+    }
 
-    // check input arguments
-    int width = image.cols;
-    int height = image.rows;
-    int dim = image.channels();
-    static const double eps = 1.0e-8;
+    result->create(height, width, CV_32FC2);
+    parallel_for(0, height, [&](int y) {
+        const float* trow = tangent.ptr<float>(y);
+        const float* grow = ghat.ptr<float>(y);
+        float* out = result->ptr<float>(y);
+        const bool innerY = y >= reachY && y < height - reachY;
+        for (int x = 0; x < width; x++) {
+            const float* tc = trow + x * 2;
+            const float* gc = grow + x;
+            const double vx = tc[0];
+            const double vy = tc[1];
+            const double gx = gc[0];
+
+            double sumx = 0.0;
+            double sumy = 0.0;
+            double weight = 0.0;
+            if (innerY && x >= reachX && x < width - reachX) {
+                for (int i = 0; i < nOffsets; i++) {
+                    const double ux = tc[tOffsets[i] + 0];
+                    const double uy = tc[tOffsets[i] + 1];
+                    const double w = (gc[gOffsets[i]] - gx + 1.0) * 0.5 * (vx * ux + vy * uy);
+                    sumx += ux * w;
+                    sumy += uy * w;
+                    weight += w;
+                }
+            } else {
+                for (int i = 0; i < nOffsets; i++) {
+                    const int xx = x + offsets[i].x;
+                    const int yy = y + offsets[i].y;
+                    if (xx < 0 || yy < 0 || xx >= width || yy >= height) continue;
+                    const double ux = tc[tOffsets[i] + 0];
+                    const double uy = tc[tOffsets[i] + 1];
+                    const double w = (gc[gOffsets[i]] - gx + 1.0) * 0.5 * (vx * ux + vy * uy);
+                    sumx += ux * w;
+                    sumy += uy * w;
+                    weight += w;
+                }
+            }
 
-    cv::Mat gray;
-    if (image.depth() != CV_32F) {
-        image.convertTo(gray, CV_MAKETYPE(CV_32F, dim), 1.0 / 255.0);
-    } else {
-        image.convertTo(gray, CV_MAKETYPE(CV_32F, dim));
-    }
+            out[x * 2 + 0] = weight != 0.0 ? static_cast<float>(sumx / weight) : 0.0f;
+            out[x * 2 + 1] = weight != 0.0 ? static_cast<float>(sumy / weight) : 0.0f;
+        }
+    });
+}
 
-    if (dim != 1) {
-        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
-    }
+/* One iteration of edge tangent flow smoothing (Kang et al. 2007)
+ * @param[in] tangent: tangent vectors (CV_32FC2)
+ * @param[in] ghat: gradient magnitude (CV_32FC1)
+ * @param[out] result: smoothed tangent vectors (CV_32FC2), must not be the same as "tangent"
+ * @param[in] ksize: radius of the neighborhood
+ * @param[in] kernel: shape of the neighborhood
+ */
+void smoothETF(const cv::Mat& tangent, const cv::Mat& ghat, cv::Mat* result, int ksize, ETFKernel kernel) {
+    std::vector<cv::Point> offsets;
+    if (kernel == ETF_KERNEL_SEPARABLE) {
+        for (int d = -ksize; d <= ksize; d++) {
+            offsets.push_back(cv::Point(d, 0));
+        }
+        cv::Mat temp;
+        smoothETFStep(tangent, ghat, offsets, &temp);
 
-    // detect standard edge
-    cv::Mat gx, gy;
-    if (edgeDetector == EDGE_SOBEL) {
-        cv::Sobel(gray, gx, CV_32FC1, 1, 0);
-        cv::Sobel(gray, gy, CV_32FC1, 0, 1);
-    } else if (edgeDetector == EDGE_ROTATIONAL) {
-        double p1 = 0.183;
-        double Dx[3][3] = { { 0.5 * p1, 0.0, -0.5 * p1 },
-        { 0.5 - p1, 0.0, p1 - 0.5 },
-        { 0.5 * p1, 0.0, -0.5 * p1 } };
-
-        gx = cv::Mat(height, width, CV_32FC1);
-        gy = cv::Mat(height, width, CV_32FC1);
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                double sumx = 0.0;
-                double sumy = 0.0;
-                double weightx = 0.0;
-                double weighty = 0.0;
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        int xx = x + dx;
-                        int yy = y + dy;
-                        if (xx >= 0 && yy >= 0 && xx < width && yy < height) {
-                            double wx = Dx[dy + 1][dx + 1];
-                            double wy = Dx[dx + 1][dy + 1];
-                            sumx += wx * gray.at<float>(yy, xx);
-                            sumy += wy * gray.at<float>(yy, xx);
-                        }
-                    }
-                }
-                gx.at<float>(y, x) = static_cast<float>(sumx);
-                gy.at<float>(y, x) = static_cast<float>(sumy);
+        for (int d = -ksize; d <= ksize; d++) {
+            offsets[d + ksize] = cv::Point(0, d);
+        }
+        smoothETFStep(temp, ghat, offsets, result);
+    } else if (kernel == ETF_KERNEL_DISK) {
+        for (int dy = -ksize; dy <= ksize; dy++) {
+            for (int dx = -ksize; dx <= ksize; dx++) {
+                if (dx * dx + dy * dy > ksize * ksize) continue;
+                offsets.push_back(cv::Point(dx, dy));
             }
         }
+        smoothETFStep(tangent, ghat, offsets, result);
     } else {
-        msg_assert(false, "Unknown edge detector is specified");
+        msg_assert(false, "Unknown ETF kernel is specified.");
     }
+}
+
+void calcETF(const ImageAnalysis& analysis, cv::OutputArray output, int ksize = 5, int maxiter = 3,
+             ETFKernel kernel = ETF_KERNEL_DISK) {
+    LIME_PROFILE_SCOPE("calcETF");
+    LIME_PROFILE_COUNT("iterations", maxiter);
+    cv::Mat& etf = output.getMatRef();
+
+    const int width = analysis.cols();
+    const int height = analysis.rows();
+    static const double eps = 1.0e-8;
 
     // compute tangent field
-    cv::Mat tangent = cv::Mat::zeros(height, width, CV_32FC2);
-    cv::Mat ghat = cv::Mat::zeros(height, width, CV_32FC1);
-    for (int y = 0; y < height; y++) {
+    cv::Mat tangent = cv::Mat(height, width, CV_32FC2);
+    cv::Mat ghat = cv::Mat(height, width, CV_32FC1);
+    parallel_for(0, height, [&](int y) {
+        const float* gx = analysis.gradX().ptr<float>(y);
+        const float* gy = analysis.gradY().ptr<float>(y);
+        const float* m = analysis.magnitude().ptr<float>(y);
+        float* t = tangent.ptr<float>(y);
+        float* g = ghat.ptr<float>(y);
         for (int x = 0; x < width; x++) {
-            double vx = gx.at<float>(y, x);
-            double vy = gy.at<float>(y, x);
-            double mag = sqrt(vx*vx + vy*vy) + eps;
-            ghat.at<float>(y, x) = static_cast<float>(mag);
-
-            tangent.at<float>(y, x * 2 + 0) = static_cast<float>(-vy / mag);
-            tangent.at<float>(y, x * 2 + 1) = static_cast<float>(vx / mag);
+            const double mag = m[x] + eps;
+            g[x] = static_cast<float>(mag);
+            t[x * 2 + 0] = static_cast<float>(-gy[x] / mag);
+            t[x * 2 + 1] = static_cast<float>(gx[x] / mag);
         }
-    }
+    });
 
     // compute ETF
-    cv::Mat temp = cv::Mat(height, width, CV_32FC2);
+    cv::Mat temp = tangent.clone();
     while (maxiter--) {
-        ompfor(int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                Point2d sum = Point2d(0.0, 0.0);
-                double weight = 0.0;
-                for (int dy = -ksize; dy <= ksize; dy++) {
-                    for (int dx = -ksize; dx <= ksize; dx++) {
-                        int xx = x + dx;
-                        int yy = y + dy;
-                        if (xx < 0 || yy < 0 || xx >= width || yy >= height) continue;
-                        if (dx * dx + dy * dy > ksize * ksize) continue;
-
-                        double vx = tangent.at<float>(y, x * 2 + 0);
-                        double vy = tangent.at<float>(y, x * 2 + 1);
-                        Point2d tx = Point2d(vx, vy);
-
-                        double ux = tangent.at<float>(yy, xx * 2 + 0);
-                        double uy = tangent.at<float>(yy, xx * 2 + 1);
-                        Point2d ty = Point2d(ux, uy);
-                        double wd = tx.dot(ty);
-
-                        double gx = ghat.at<float>(y, x);
-                        double gy = ghat.at<float>(yy, xx);
-                        double wm = (gy - gx + 1.0) / 2.0;
-
-                        sum = sum + ty * (wm * wd);
-                        weight += wm * wd;
-                    }
-                }
-
-                Point2d v = weight != 0.0 ? sum / weight : Point2d(0.0, 0.0);
-                temp.at<float>(y, x * 2 + 0) = static_cast<float>(v.x);
-                temp.at<float>(y, x * 2 + 1) = static_cast<float>(v.y);
-            }
-        }
+        smoothETF(tangent, ghat, &temp, ksize, kernel);
 
-        temp.convertTo(tangent, CV_32FC2);
-        for (int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](int y) {
+            const float* src = temp.ptr<float>(y);
+            float* dst = tangent.ptr<float>(y);
             for (int x = 0; x < width; x++) {
-                double vx = tangent.at<float>(y, x * 2 + 0);
-                double vy = tangent.at<float>(y, x * 2 + 1);
+                double vx = src[x * 2 + 0];
+                double vy = src[x * 2 + 1];
                 double mag = sqrt(vx * vx + vy * vy) + eps;
-                tangent.at<float>(y, x * 2 + 0) = static_cast<float>(vx / mag);
-                tangent.at<float>(y, x * 2 + 1) = static_cast<float>(vy / mag);
+                dst[x * 2 + 0] = static_cast<float>(vx / mag);
+                dst[x * 2 + 1] = static_cast<float>(vy / mag);
             }
-        }
+        });
     }
 
     // compute tangent direction with angle
     temp.convertTo(etf, CV_32F);
 }
 
-void calcSST(cv::InputArray input, cv::OutputArray output, int ksize = 5, EdgeDetector edgeDetector = EDGE_SOBEL) {
-    cv::Mat  image = input.getMat();
-    cv::Mat& sst   = output.getMatRef();
+void calcETF(cv::InputArray input, cv::OutputArray output, int ksize = 5, int maxiter = 3,
+             EdgeDetector edgeDetector = EDGE_SOBEL, ETFKernel kernel = ETF_KERNEL_DISK) {
+    calcETF(ImageAnalysis(input, edgeDetector), output, ksize, maxiter, kernel);
+}
 
-    int width = image.cols;
-    int height = image.rows;
-    int dim = image.channels();
+// * outer products of the gradients (E, F, G)
+void calcGradientTensor(const ImageAnalysis& analysis, TensorField* field) {
+    const int width = analysis.cols();
+    const int height = analysis.rows();
+
+    *field = TensorField(height, width);
+    parallel_for(0, height, [&](int y) {
+        const float* gx = analysis.gradX().ptr<float>(y);
+        const float* gy = analysis.gradY().ptr<float>(y);
+        float* E = field->E(y);
+        float* F = field->F(y);
+        float* G = field->G(y);
+        for (int x = 0; x < width; x++) {
+            E[x] = gx[x] * gx[x];
+            F[x] = gx[x] * gy[x];
+            G[x] = gy[x] * gy[x];
+        }
+    });
+}
 
-    const int offset[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+/* Relax the tensors. Pixels with large energy are replaced by the average of
+ * their 4-neighbors in the previous step. Two fields are swapped between the
+ * steps, so that the rows are processed in parallel without copying.
+ */
+void relaxTensor(TensorField* field, int maxiter, float tau) {
+    const int width = field->cols();
+    const int height = field->rows();
+    float* (TensorField::*planes[3])(int) const = { &TensorField::E, &TensorField::F, &TensorField::G };
+
+    TensorField next(height, width);
+    for (int it = 0; it < maxiter; it++) {
+        const TensorField& cur = *field;
+        parallel_for(0, height, [&](int y) {
+            const float* E = cur.E(y);
+            const float* F = cur.F(y);
+            const float* G = cur.G(y);
+            const float cntY = static_cast<float>((y > 0) + (y < height - 1));
+            for (int c = 0; c < 3; c++) {
+                const float* src = (cur.*planes[c])(y);
+                const float* up = y > 0 ? (cur.*planes[c])(y - 1) : 0;
+                const float* down = y < height - 1 ? (cur.*planes[c])(y + 1) : 0;
+                float* dst = (next.*planes[c])(y);
+                for (int x = 0; x < width; x++) {
+                    const float eng = std::sqrt(E[x] * E[x] + 2.0f * F[x] * F[x] + G[x] * G[x]);
+                    if (eng <= tau) {
+                        dst[x] = src[x];
+                        continue;
+                    }
 
-    cv::Mat gray;
-    if (image.depth() != CV_32F) {
-        image.convertTo(gray, CV_MAKETYPE(CV_32F, dim), 1.0 / 255.0);
-    } else {
-        image.convertTo(gray, CV_MAKETYPE(CV_32F, dim));
+                    float sum = 0.0f;
+                    if (x > 0) sum += src[x - 1];
+                    if (x < width - 1) sum += src[x + 1];
+                    if (up) sum += up[x];
+                    if (down) sum += down[x];
+                    dst[x] = sum / (cntY + static_cast<float>((x > 0) + (x < width - 1)));
+                }
+            }
+        });
+        std::swap(*field, next);
     }
+}
+
+/* Box filter of size (2 * radius + 1). Borders are reflected. Every window is
+ * summed directly in the same order instead of by running sums, so that the
+ * result depends only on the values in the window, and not on where the rows
+ * and columns start (e.g., tiles and dirty regions of an image).
+ */
+template <class RowPtr>
+void boxFilterRows(const RowPtr& rowPtr, int width, int height, int radius) {
+    const float scale = 1.0f / (2 * radius + 1);
+    cv::Mat temp(height, width, CV_32FC1);
+
+    // horizontal (the offsets in the window are added in ascending order for every pixel)
+    parallel_for(0, height, [&](int y) {
+        const float* src = rowPtr(y);
+        float* dst = temp.ptr<float>(y);
+        std::fill(dst, dst + width, 0.0f);
+        for (int d = -radius; d <= radius; d++) {
+            const int x0 = std::min(std::max(-d, 0), width);
+            const int x1 = std::max(std::min(width - d, width), x0);
+            for (int x = 0; x < x0; x++) dst[x] += src[reflect101(x + d, width)];
+            for (int x = x0; x < x1; x++) dst[x] += src[x + d];
+            for (int x = x1; x < width; x++) dst[x] += src[reflect101(x + d, width)];
+        }
+        for (int x = 0; x < width; x++) dst[x] *= scale;
+    });
+
+    // vertical
+    parallel_for(0, height, [&](int y) {
+        float* dst = rowPtr(y);
+        std::fill(dst, dst + width, 0.0f);
+        for (int d = -radius; d <= radius; d++) {
+            const float* src = temp.ptr<float>(reflect101(y + d, height));
+            for (int x = 0; x < width; x++) dst[x] += src[x];
+        }
+        for (int x = 0; x < width; x++) dst[x] *= scale;
+    });
+}
+
+void calcSST(const ImageAnalysis& analysis, TensorField* field, int ksize = 5) {
+    LIME_PROFILE_SCOPE("calcSST");
+    const int width = analysis.cols();
+    const int height = analysis.rows();
+
+    // structure tensor from 3x3 gradients
+    calcGradientTensor(analysis, field);
 
-    if (dim != 1) {
-        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+    // tensor relaxation step
+    relaxTensor(field, SST_RELAX_ITERATIONS, SST_RELAX_THRESHOLD);
+
+    // smoothing. The tensors used to be smoothed by cv::GaussianBlur with
+    // ksize x ksize kernel and sigma = 2 * ksize^2, whose weights are almost
+    // flat over the kernel, so that a box filter gives the same result.
+    const int radius = ksize / 2;
+    boxFilterRows([&](int y) { return field->E(y); }, width, height, radius);
+    boxFilterRows([&](int y) { return field->F(y); }, width, height, radius);
+    boxFilterRows([&](int y) { return field->G(y); }, width, height, radius);
+}
+
+void calcSST(cv::InputArray input, TensorField* field, int ksize = 5, EdgeDetector edgeDetector = EDGE_SOBEL) {
+    calcSST(ImageAnalysis(input, edgeDetector), field, ksize);
+}
+
+// * tensors whose minor eigenvectors are the given tangents (CV_32FC2)
+void tangentToTensor(const cv::Mat& tangent, TensorField* field) {
+    const int width = tangent.cols;
+    const int height = tangent.rows;
+
+    *field = TensorField(height, width);
+    parallel_for(0, height, [&](int y) {
+        const float* t = tangent.ptr<float>(y);
+        float* E = field->E(y);
+        float* F = field->F(y);
+        float* G = field->G(y);
+        for (int x = 0; x < width; x++) {
+            const float tx = t[x * 2 + 0];
+            const float ty = t[x * 2 + 1];
+            const float mag2 = tx * tx + ty * ty;
+            if (mag2 == 0.0f) continue;
+
+            // outer product of the normal (-ty, tx) / |t|
+            E[x] = ty * ty / mag2;
+            F[x] = -tx * ty / mag2;
+            G[x] = tx * tx / mag2;
+        }
+    });
+}
+
+/* Joint bilateral upsampling of tensors (Kopf et al. 2007). Each pixel takes
+ * the 2x2 coarse tensors around it, weighted bilinearly and by the difference
+ * between the fine and coarse guide intensities, so that the tensors do not
+ * leak across the edges of the guide.
+ */
+void upsampleTensor(const TensorField& coarse, const cv::Mat& coarseGuide, const cv::Mat& guide,
+                    TensorField* field) {
+    const int width = guide.cols;
+    const int height = guide.rows;
+    const double sigmaR = 0.1;
+
+    // range weights for the intensity difference quantized into bins
+    const int nBins = 256;
+    std::vector<float> rangeLUT(nBins + 1);
+    for (int i = 0; i <= nBins; i++) {
+        const double d = static_cast<double>(i) / nBins;
+        rangeLUT[i] = static_cast<float>(exp(-d * d / (2.0 * sigmaR * sigmaR)));
     }
 
-    // detect standard edge
-    cv::Mat gx, gy;
-    if (edgeDetector == EDGE_SOBEL) {
-        cv::Sobel(gray, gx, CV_32FC1, 1, 0);
-        cv::Sobel(gray, gy, CV_32FC1, 0, 1);
-    } else if (edgeDetector == EDGE_ROTATIONAL) {
-        double p1 = 0.183;
-        double Dx[3][3] = { { 0.5 * p1, 0.0, -0.5 * p1 },
-        { 0.5 - p1, 0.0, p1 - 0.5 },
-        { 0.5 * p1, 0.0, -0.5 * p1 } };
-
-        gx = cv::Mat(height, width, CV_32FC1);
-        gy = cv::Mat(height, width, CV_32FC1);
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                double sumx = 0.0;
-                double sumy = 0.0;
-                double weightx = 0.0;
-                double weighty = 0.0;
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        int xx = x + dx;
-                        int yy = y + dy;
-                        if (xx >= 0 && yy >= 0 && xx < width && yy < height) {
-                            double wx = Dx[dy + 1][dx + 1];
-                            double wy = Dx[dx + 1][dy + 1];
-                            sumx += wx * gray.at<float>(yy, xx);
-                            sumy += wy * gray.at<float>(yy, xx);
-                        }
-                    }
+    // coarse indices and bilinear weights of the 2 taps for each row or column
+    struct Taps {
+        int index[2];
+        float weight[2];
+    };
+    auto makeTaps = [&](int n, int cn) -> std::vector<Taps> {
+        std::vector<Taps> taps(n);
+        for (int i = 0; i < n; i++) {
+            const double c = std::max(0.0, std::min((i + 0.5) * cn / n - 0.5, cn - 1.0));
+            const int c0 = std::min(static_cast<int>(c), cn - 1);
+            const double t = c - c0;
+            taps[i].index[0] = c0;
+            taps[i].index[1] = std::min(c0 + 1, cn - 1);
+            taps[i].weight[0] = static_cast<float>(1.0 - t);
+            taps[i].weight[1] = static_cast<float>(t);
+        }
+        return taps;
+    };
+    const std::vector<Taps> tapX = makeTaps(width, coarse.cols());
+    const std::vector<Taps> tapY = makeTaps(height, coarse.rows());
+
+    *field = TensorField(height, width);
+    parallel_for(0, height, [&](int y) {
+        const Taps& ty = tapY[y];
+        const float* g = guide.ptr<float>(y);
+        float* E = field->E(y);
+        float* F = field->F(y);
+        float* G = field->G(y);
+        for (int x = 0; x < width; x++) {
+            const Taps& tx = tapX[x];
+            float sumE = 0.0f;
+            float sumF = 0.0f;
+            float sumG = 0.0f;
+            float weight = 0.0f;
+            for (int i = 0; i < 2; i++) {
+                const int cy = ty.index[i];
+                const float* cg = coarseGuide.ptr<float>(cy);
+                const float* cE = coarse.E(cy);
+                const float* cF = coarse.F(cy);
+                const float* cG = coarse.G(cy);
+                for (int j = 0; j < 2; j++) {
+                    const int cx = tx.index[j];
+                    const float d = std::min(std::abs(g[x] - cg[cx]), 1.0f);
+                    const float w = ty.weight[i] * tx.weight[j] * rangeLUT[static_cast<int>(d * nBins)];
+                    sumE += w * cE[cx];
+                    sumF += w * cF[cx];
+                    sumG += w * cG[cx];
+                    weight += w;
                 }
-                gx.at<float>(y, x) = static_cast<float>(sumx);
-                gy.at<float>(y, x) = static_cast<float>(sumy);
             }
+            E[x] = sumE / weight;
+            F[x] = sumF / weight;
+            G[x] = sumG / weight;
         }
-    } else {
-        msg_assert(false, "Unknown edge detector is specified.");
-    }
+    });
+}
 
-    // tensor relaxation step
-    cv::Mat efg = cv::Mat(height, width, CV_64FC3);
-    for (int y = 0; y < height; y++) {
+/* Refine the anisotropic tensors, whose orientation can be displaced near the
+ * edges by upsampling, with the average of full-resolution gradient tensors
+ * within the given radius. Both are normalized by their traces before adding.
+ */
+void refineTensor(TensorField* field, const TensorField& gradient, int radius, float threshold) {
+    const int width = field->cols();
+    const int height = field->rows();
+
+    parallel_for(0, height, [&](int y) {
+        float* E = field->E(y);
+        float* F = field->F(y);
+        float* G = field->G(y);
         for (int x = 0; x < width; x++) {
-            double fx = gx.at<float>(y, x);
-            double fy = gy.at<float>(y, x);
-            efg.at<double>(y, x * 3 + 0) = fx * fx;
-            efg.at<double>(y, x * 3 + 1) = fx * fy;
-            efg.at<double>(y, x * 3 + 2) = fy * fy;
+            const float s = E[x] + G[x];
+            const float d = std::sqrt((E[x] - G[x]) * (E[x] - G[x]) + 4.0f * F[x] * F[x]);
+            if (s <= 0.0f || d < threshold * s) continue;
+
+            float rE = 0.0f;
+            float rF = 0.0f;
+            float rG = 0.0f;
+            for (int yy = std::max(0, y - radius); yy <= std::min(height - 1, y + radius); yy++) {
+                const float* gE = gradient.E(yy);
+                const float* gF = gradient.F(yy);
+                const float* gG = gradient.G(yy);
+                for (int xx = std::max(0, x - radius); xx <= std::min(width - 1, x + radius); xx++) {
+                    rE += gE[xx];
+                    rF += gF[xx];
+                    rG += gG[xx];
+                }
+            }
+
+            const float rs = rE + rG;
+            if (rs <= 0.0f) continue;
+            E[x] = E[x] / s + rE / rs;
+            F[x] = F[x] / s + rF / rs;
+            G[x] = G[x] / s + rG / rs;
         }
+    });
+}
+
+/* Zero of (u, v) linearly interpolated in a triangle. Its barycentric
+ * coordinates are the cross products of the values at the other two
+ * vertices, normalized by their sum, which is the Jacobian of (u, v)
+ * multiplied by the signed area of the triangle.
+ * @param[in] u, v: values at the three vertices
+ * @param[out] b: barycentric coordinates of the zero
+ * @return sign of the sum of the cross products if the zero is inside the triangle, otherwise 0
+ */
+int triangleZero(const double u[3], const double v[3], double b[3]) {
+    const double c0 = u[1] * v[2] - u[2] * v[1];
+    const double c1 = u[2] * v[0] - u[0] * v[2];
+    const double c2 = u[0] * v[1] - u[1] * v[0];
+    const double det = c0 + c1 + c2;
+    if (det > 0.0) {
+        if (c0 < 0.0 || c1 < 0.0 || c2 < 0.0) return 0;
+    } else if (det < 0.0) {
+        if (c0 > 0.0 || c1 > 0.0 || c2 > 0.0) return 0;
+    } else {
+        return 0;
+    }
+
+    b[0] = c0 / det;
+    b[1] = c1 / det;
+    b[2] = c2 / det;
+    return det > 0.0 ? 1 : -1;
+}
+
+// * orientation or unit tangent vectors of the tensors
+void tensorToField(const TensorField& field, cv::Mat* vfield, VFieldOutput output) {
+    if (output == VFIELD_VECTORS) {
+        field.tangent(*vfield);
+    } else if (output == VFIELD_ANGLES) {
+        field.orientation(*vfield);
+    } else {
+        msg_assert(false, "Unknown output format is specified.");
     }
+}
 
-    cv::Mat tmp;
-    efg.convertTo(tmp, CV_64FC3);
-    const double tau = 0.002;
-    for (int it = 0; it < 5; it++) {
-        for (int y = 0; y < height; y++) {
+/* Angles or unit vectors of ETF. Zero vectors are given angle 0 (i.e., vector (1, 0))
+ * in both formats, as atan2 does.
+ */
+void tangentToField(const cv::Mat& etf, cv::Mat* vfield, VFieldOutput output) {
+    const int width = etf.cols;
+    const int height = etf.rows;
+    if (output == VFIELD_VECTORS) {
+        vfield->create(height, width, CV_32FC2);
+        parallel_for(0, height, [&](int y) {
+            const float* t = etf.ptr<float>(y);
+            float* v = vfield->ptr<float>(y);
             for (int x = 0; x < width; x++) {
-                double E = efg.at<double>(y, x * 3 + 0);
-                double F = efg.at<double>(y, x * 3 + 1);
-                double G = efg.at<double>(y, x * 3 + 2);
-
-                double eng = sqrt(E * E + 2.0 * F * F + G * G);
-                if (eng > tau) {
-                    double sumE = 0.0;
-                    double sumF = 0.0;
-                    double sumG = 0.0;
-                    double cnt = 0.0;
-                    for (int k = 0; k < 4; k++) {
-                        int xx = x + offset[k][0];
-                        int yy = y + offset[k][1];
-                        if (xx >= 0 && yy >= 0 && xx < width && yy < height) {
-                            sumE += tmp.at<double>(yy, xx * 3 + 0);
-                            sumF += tmp.at<double>(yy, xx * 3 + 1);
-                            sumG += tmp.at<double>(yy, xx * 3 + 2);
-                            cnt += 1.0;
-                        }
-                    }
-                    efg.at<double>(y, x * 3 + 0) = sumE / cnt;
-                    efg.at<double>(y, x * 3 + 1) = sumF / cnt;
-                    efg.at<double>(y, x * 3 + 2) = sumG / cnt;
-                }
+                const float tx = t[x * 2 + 0];
+                const float ty = t[x * 2 + 1];
+                const float n2 = tx * tx + ty * ty;
+                const float inv = 1.0f / std::sqrt(n2 > 0.0f ? n2 : 1.0f);
+                v[x * 2 + 0] = n2 > 0.0f ? tx * inv : 1.0f;
+                v[x * 2 + 1] = ty * inv;
             }
-        }
-        efg.convertTo(tmp, CV_64FC3);
+        });
+    } else if (output == VFIELD_ANGLES) {
+        vfield->create(height, width, CV_32FC1);
+        parallel_for(0, height, [&](int y) {
+            const float* t = etf.ptr<float>(y);
+            float* a = vfield->ptr<float>(y);
+            for (int x = 0; x < width; x++) {
+                a[x] = fastAtan2(t[x * 2 + 1], t[x * 2 + 0]);
+            }
+        });
+    } else {
+        msg_assert(false, "Unknown output format is specified.");
     }
-
-    efg.convertTo(efg, CV_32F);
-    double sigma = 2.0 * ksize * ksize;
-    cv::GaussianBlur(efg, sst, cv::Size(ksize, ksize), sigma);
 }
 
 }  // unnamed namespace
 
+void calcVectorField(const ImageAnalysis& analysis, cv::OutputArray angles, int ksize, VFieldType vfieldType,
+                     VFieldOutput output) {
+    LIME_PROFILE_SCOPE("calcVectorField");
+    LIME_PROFILE_COUNT("pixels", analysis.rows() * analysis.cols());
+
+    cv::Mat& vfield = angles.getMatRef();
+    if (vfieldType == VECTOR_SST) {
+        TensorField sst;
+        calcStructureTensor(analysis, &sst, ksize);
+        tensorToField(sst, &vfield, output);
+    } else if (vfieldType == VECTOR_ETF || vfieldType == VECTOR_ETF_SEPARABLE) {
+        const ETFKernel kernel = vfieldType == VECTOR_ETF ? ETF_KERNEL_DISK : ETF_KERNEL_SEPARABLE;
+        cv::Mat etf;
+        npr::calcETF(analysis, etf, ksize, ETF_ITERATIONS, kernel);
+        tangentToField(etf, &vfield, output);
+    } else {
+        msg_assert(false, "Unknown vector field type is specified.");
+    }
+}
+
 void calcVectorField(cv::InputArray input, cv::OutputArray angles,
-                     int ksize, VFieldType vfieldType, EdgeDetector edgeDetector) {
+                     int ksize, VFieldType vfieldType, EdgeDetector edgeDetector, VFieldOutput output) {
+    calcVectorField(ImageAnalysis(input, edgeDetector), angles, ksize, vfieldType, output);
+}
+
+void calcVectorFieldPyramid(cv::InputArray input, cv::OutputArray angles, int ksize,
+                            VFieldType vfieldType, EdgeDetector edgeDetector, int levels, VFieldOutput output) {
+    LIME_PROFILE_SCOPE("calcVectorFieldPyramid");
     cv::Mat image = input.getMat();
+    LIME_PROFILE_COUNT("pixels", image.rows * image.cols);
 
     const int width = image.cols;
     const int height = image.rows;
 
-    cv::Mat& vfield = angles.getMatRef();
-    vfield = cv::Mat(height, width, CV_32FC1);
-    if (vfieldType == VECTOR_SST) {
-        cv::Mat sst;
-        npr::calcSST(image, sst, ksize, edgeDetector);
-
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                double E = sst.at<float>(y, x * 3 + 0);
-                double F = sst.at<float>(y, x * 3 + 1);
-                double G = sst.at<float>(y, x * 3 + 2);
-                double D = sqrt((E - G) * (E - G) + 4.0 * F * F);
-                double lambda1 = (E + G + D) / 2.0;
-                double lambda2 = (E + G - D) / 2.0;
-                double lambda = abs(lambda1) > abs(lambda2) ? lambda1 : lambda2;
-                vfield.at<float>(y, x) = static_cast<float>(atan2(-F, lambda1 - E));
-            }
+    // the kernel at the coarsest level should still cover 5 pixels
+    if (levels < 0) {
+        levels = 0;
+        while ((ksize >> (levels + 1)) >= 5 && (std::min(width, height) >> (levels + 1)) >= 16) {
+            levels++;
         }
-    } else if (vfieldType == VECTOR_ETF) {
+    }
+
+    const ImageAnalysis analysis(image, edgeDetector);
+    if (levels == 0) {
+        calcVectorField(analysis, angles, ksize, vfieldType, output);
+        return;
+    }
+
+    const int scale = 1 << levels;
+    const int coarseKsize = std::max(3, (ksize / scale) | 1);
+    const cv::Mat& gray = analysis.gray();
+    cv::Mat coarseGray;
+    cv::resize(gray, coarseGray, cv::Size(std::max(1, width / scale), std::max(1, height / scale)),
+               0.0, 0.0, cv::INTER_AREA);
+
+    TensorField coarse;
+    if (vfieldType == VECTOR_SST) {
+        calcSST(coarseGray, &coarse, coarseKsize, edgeDetector);
+    } else if (vfieldType == VECTOR_ETF || vfieldType == VECTOR_ETF_SEPARABLE) {
+        const ETFKernel kernel = vfieldType == VECTOR_ETF ? ETF_KERNEL_DISK : ETF_KERNEL_SEPARABLE;
         cv::Mat etf;
-        npr::calcETF(image, etf, ksize, edgeDetector);
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                double tx = etf.at<double>(y, x * 2 + 0);
-                double ty = etf.at<double>(y, x * 2 + 1);
-                vfield.at<float>(y, x) = static_cast<float>(atan2(ty, tx));
-            }
-        }
+        npr::calcETF(coarseGray, etf, coarseKsize, ETF_ITERATIONS, edgeDetector, kernel);
+        tangentToTensor(etf, &coarse);
     } else {
         msg_assert(false, "Unknown vector field type is specified.");
     }
+
+    TensorField field;
+    upsampleTensor(coarse, coarseGray, gray, &field);
+
+    TensorField gradient;
+    calcGradientTensor(analysis, &gradient);
+    refineTensor(&field, gradient, scale / 2, 0.5f);
+
+    tensorToField(field, &angles.getMatRef(), output);
 }
 
-void detectSingular(const Array2d<Tensor>& sst, std::vector<SingularPoint>* points,
-                    std::vector<cv::Point2f>* delauneyNodes) {
+void calcStructureTensor(const ImageAnalysis& analysis, TensorField* field, int ksize) {
+    npr::calcSST(analysis, field, ksize);
+}
+
+void calcStructureTensor(cv::InputArray input, TensorField* field, int ksize, EdgeDetector edgeDetector) {
+    npr::calcSST(input, field, ksize, edgeDetector);
+}
+
+void detectSingular(const TensorField& sst, std::vector<SingularPoint>* points) {
+    LIME_PROFILE_SCOPE("detectSingular");
     const int width = sst.cols();
     const int height = sst.rows();
 
-    if (delauneyNodes->empty()) {
-        cv::Mat white = cv::Mat::ones(height, width, CV_32FC1);
-        lime::npr::poissonDisk(white, delauneyNodes, lime::npr::PDS_FAST_PARALLEL, 3.0, 5.0);
-    }
+    // Each pixel quad is split into two triangles, in which (E - G, F) is linearly
+    // interpolated. Both triangles have the same orientation as the image axes,
+    // so that the sign of the Jacobian tells the type of the singularity.
+    std::vector<std::vector<SingularPoint> > rowPoints(std::max(0, height - 1));
+    parallel_for(0, height - 1, [&](int y) {
+        const float* E0 = sst.E(y);
+        const float* F0 = sst.F(y);
+        const float* G0 = sst.G(y);
+        const float* E1 = sst.E(y + 1);
+        const float* F1 = sst.F(y + 1);
+        const float* G1 = sst.G(y + 1);
+        std::vector<SingularPoint>& found = rowPoints[y];
+
+        auto test = [&](const double u[3], const double v[3], const double px[3], const double py[3]) {
+            double b[3];
+            const int jacobian = triangleZero(u, v, b);
+            if (jacobian == 0) return;
+
+            const int x = static_cast<int>(b[0] * px[0] + b[1] * px[1] + b[2] * px[2]);
+            const int y = static_cast<int>(b[0] * py[0] + b[1] * py[1] + b[2] * py[2]);
+            found.push_back(SingularPoint(x, y, 0.0, jacobian > 0 ? SINGULAR_WEDGE : SINGULAR_TRISECTOR));
+        };
+
+        const double y0 = y;
+        const double y1 = y + 1;
+        for (int x = 0; x < width - 1; x++) {
+            const double x0 = x;
+            const double x1 = x + 1;
+            const double u00 = E0[x] - G0[x];
+            const double u10 = E0[x + 1] - G0[x + 1];
+            const double u01 = E1[x] - G1[x];
+            const double u11 = E1[x + 1] - G1[x + 1];
+
+            // upper left triangle
+            const double ua[3] = { u00, u10, u01 };
+            const double va[3] = { F0[x], F0[x + 1], F1[x] };
+            const double xa[3] = { x0, x1, x0 };
+            const double ya[3] = { y0, y0, y1 };
+            test(ua, va, xa, ya);
+
+            // lower right triangle
+            const double ub[3] = { u11, u01, u10 };
+            const double vb[3] = { F1[x + 1], F1[x], F0[x + 1] };
+            const double xb[3] = { x1, x0, x1 };
+            const double yb[3] = { y1, y1, y0 };
+            test(ub, vb, xb, yb);
+        }
+    });
 
-    cv::Rect(0, 0, width, height);
-    cv::Subdiv2D subdiv(cv::Rect(0, 0, width, height));
-    for (int i = 0; i < delauneyNodes->size(); i++) {
-        subdiv.insert(delauneyNodes[i]);
+    // zeros on the shared edges are found in both triangles with the same type,
+    // while a wedge and a trisector in the same pixel are different singularities
+    points->clear();
+    for (int y = 0; y < height - 1; y++) {
+        points->insert(points->end(), rowPoints[y].begin(), rowPoints[y].end());
     }
+    std::stable_sort(points->begin(), points->end(), [](const SingularPoint& p, const SingularPoint& q) {
+        if (p.y != q.y) return p.y < q.y;
+        if (p.x != q.x) return p.x < q.x;
+        return p.type < q.type;
+    });
+    points->erase(std::unique(points->begin(), points->end(), [](const SingularPoint& p, const SingularPoint& q) {
+        return p.x == q.x && p.y == q.y && p.type == q.type;
+    }), points->end());
+}
 
-    std::vector<cv::Vec6f> tri;
-    subdiv.getTriangleList(tri);
-    for (int i = 0; i < tri.size(); i++) {
-        cv::Mat A = cv::Mat::ones(3, 3, CV_64FC1);
-        int x1 = static_cast<int>(tri[i][0]);
-        int y1 = static_cast<int>(tri[i][1]);
-        if (x1 < 0 || y1 < 0 || x1 >= width || y1 >= height) continue;
-        A.at<double>(0, 0) = sst(y1, x1).elem(0, 0) - sst(y1, x1).elem(1, 1);
-        A.at<double>(1, 0) = sst(y1, x1).elem(0, 1);
-
-        int x2 = static_cast<int>(tri[i][2]);
-        int y2 = static_cast<int>(tri[i][3]);
-        if (x2 < 0 || y2 < 0 || x2 >= width || y2 >= height) continue;
-        A.at<double>(0, 1) = sst(y2, x2).elem(0, 0) - sst(y2, x2).elem(1, 1);
-        A.at<double>(1, 1) = sst(y2, x2).elem(0, 1);
-
-        int x3 = static_cast<int>(tri[i][4]);
-        int y3 = static_cast<int>(tri[i][5]);
-        if (x3 < 0 || y3 < 0 || x3 >= width || y3 >= height) continue;
-        A.at<double>(0, 2) = sst(y3, x3).elem(0, 0) - sst(y3, x3).elem(1, 1);
-        A.at<double>(1, 2) = sst(y3, x3).elem(0, 1);
-
-        cv::Mat b = cv::Mat::zeros(3, 1, CV_64FC1);
-        b.at<double>(2, 0) = 1.0;
-
-        cv::Mat p = cv::Mat(b.size(), CV_64FC1);
-        if (cv::determinant(A) != 0) {
-            cv::solve(A, b, p);
-            double p1 = p.at<double>(0, 0);
-            double p2 = p.at<double>(1, 0);
-            double p3 = p.at<double>(2, 0);
-            if (p1 >= 0.0 && p2 >= 0.0 && p3 >= 0.0) {
-                int px = static_cast<int>(p1 * x1 + p2 * x2 + p3 * x3);
-                int py = static_cast<int>(p1 * y1 + p2 * y2 + p3 * y3);
-                if (px >= 1 && py >= 1 && px < width - 1 && py < height - 1) {
-                    // determine type of singularity
-                    Tensor Tx = (sst(py, px + 1) - sst(py, px - 1)) * 0.5;
-                    Tensor Ty = (sst(py + 1, px) - sst(py - 1, px)) * 0.5;
-                    double h11 = 0.25 * (Tx.elem(0, 0) - Tx.elem(1, 1));
-                    double h21 = 0.5 * Tx.elem(0, 1);
-                    double h12 = 0.25 * (Ty.elem(0, 0) - Ty.elem(1, 1));
-                    double h22 = 0.5 * Ty.elem(0, 1);
-                    double delta = h11 * h22 - h12 * h21;
-                    double idx = 1 - 0.5 * (2.0 - sign(delta));
-                    if (sign(delta) > 0) {
-                        points->push_back(SingularPoint(px, py, 0.0, SINGULAR_WEDGE));
-                    } else if (sign(delta) < 0) {
-                        points->push_back(SingularPoint(px, py, 0.0, SINGULAR_TRISECTOR));
-                    } else {
-                        points->push_back(SingularPoint(px, py, 0.0, SINGULAR_HIGHER_ORDER));
-                    }
-                }
-            }
-        }
-    }
+void detectSingular(const Array2d<Tensor>& sst, std::vector<SingularPoint>* points) {
+    detectSingular(TensorField(sst), points);
+}
+
+void detectSingular(const TensorField& sst, std::vector<SingularPoint>* points,
+                    std::vector<cv::Point2f>* /* delauneyNodes */) {
+    detectSingular(sst, points);
+}
+
+void detectSingular(const Array2d<Tensor>& sst, std::vector<SingularPoint>* points,
+                    std::vector<cv::Point2f>* /* delauneyNodes */) {
+    detectSingular(TensorField(sst), points);
 }
 
 }  // namespace npr
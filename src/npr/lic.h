@@ -23,8 +23,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SRC_NPR_LIC_H_
 
 #include <cmath>
+#include <vector>
+#include <functional>
 
 #include "../core/Point.hpp"
+#include "CompactVectorField.h"
 
 namespace lime {
 
@@ -33,7 +36,68 @@ namespace npr {
 enum LicAlgo {
     LIC_CLASSIC = 0x01,
     LIC_EULARIAN,
-    LIC_RUNGE_KUTTA
+    LIC_RUNGE_KUTTA,
+    LIC_FAST
+};
+
+// * receiver of the frames of animated LIC with the frame index and the image
+typedef std::function<void(int, const cv::Mat&)> LicFrameCallback;
+
+/* Streamlines of LIC traced once from a vector field. The samples of each pixel
+ * are stored as the pixel indices, the weights and the arc lengths in the compressed
+ * sparse rows, so that LIC of the images sharing the vector field, and each of its
+ * iterations, is a sparse gather of the input image. Each sample takes 12 bytes,
+ * i.e., about 24L bytes per pixel for LIC_EULARIAN and LIC_RUNGE_KUTTA.
+ */
+class StreamlineCache {
+ public:
+    StreamlineCache();
+
+    /* Trace the streamlines
+     * @param[in] tangent: cv::Mat of CV_32FC2 depth which specifies a tangent direction to each pixel
+     * @param[in] L: convolution length
+     * @param[in] algo_type: LIC_CLASSIC, LIC_EULARIAN or LIC_RUNGE_KUTTA (LIC_FAST aborts the program)
+     */
+    StreamlineCache(const cv::Mat& tangent, int L, LicAlgo algo_type = LIC_EULARIAN);
+
+    StreamlineCache(const CompactVectorField& tangent, int L, LicAlgo algo_type = LIC_EULARIAN);
+
+    inline int rows() const { return nrows; }
+    inline int cols() const { return ncols; }
+    inline int length() const { return L; }
+    inline LicAlgo algorithm() const { return algo; }
+
+    // * number of convolutions applied by lic
+    inline int iterations() const;
+
+    // * total number of the samples
+    inline size_t samples() const { return indices.size(); }
+
+    /* Convolve an image once along the streamlines
+     * @param[in] input: continuous CV_32F image of the same size with at most 4 channels
+     * @param[out] output: output image, which must not share the data with the input
+     */
+    inline void convolve(const cv::Mat& input, cv::Mat* output) const;
+
+    /* Frames of animated LIC, whose kernels are modulated by the ripple
+     * (1 + cos(2 PI (s / period + i / frames))) / 2 at the arc length s for the i-th frame.
+     * The samples are gathered only once, and each frame is a blend of them per pixel.
+     * @param[in] input: continuous CV_32F image of the same size with at most 4 channels
+     * @param[in] frames: number of the frames in a cycle of the motion
+     * @param[in] period: period of the ripple along the streamlines in pixels
+     * @param[in] callback: receiver of the frames, whose image is overwritten by the next frame
+     */
+    inline void animate(const cv::Mat& input, int frames, double period, const LicFrameCallback& callback) const;
+
+ private:
+    int nrows, ncols;
+    int L;
+    LicAlgo algo;
+    std::vector<size_t> offsets;
+    std::vector<int> indices;
+    std::vector<float> weights;
+    std::vector<float> positions;
+    std::vector<float> totals;
 };
 
 /* Visualize a vector field using line integral convolusion (LIC)
@@ -46,10 +110,37 @@ enum LicAlgo {
 *      NPR_LIC_CLASSIC: slow but outputs beautiful vector field
 *      NPR_LIC_EULARIAN: fast and stable algorithm (default)
 *      NPR_LIC_RUNGE_KUTTA: second-order line integration
+*      NPR_LIC_FAST: box kernel of length 2L+1 applied along long streamlines, each of
+*                    which is shared by the pixels on it (FastLIC)
 */
 inline void lic(cv::OutputArray out, cv::InputArray img,
                 const cv::Mat& tangent, int L, LicAlgo algo_type = LIC_EULARIAN);
 
+/* LIC with a compact vector field, which reduces the memory traffic of
+ * tracing streamlines. The vectors are quantized to 4096 angles.
+ * @param[in] tangent: tangent directions of the same size as the input image
+ */
+inline void lic(cv::OutputArray out, cv::InputArray img,
+                const CompactVectorField& tangent, int L, LicAlgo algo_type = LIC_EULARIAN);
+
+/* LIC along the cached streamlines, which are traced only once for the images
+ * sharing the same vector field
+ * @param[in] cache: streamlines of the same size as the input image
+ */
+inline void lic(cv::OutputArray out, cv::InputArray img, const StreamlineCache& cache);
+
+/* Animated LIC (Forssell and Cabral 1995), in which the texture flows along the vector
+ * field and the frames loop seamlessly. A sequence takes little more than a single
+ * convolution, since the streamlines are cached and the samples are gathered only once.
+ * @param[in] img: input image, typically white noise
+ * @param[in] cache: streamlines of the same size as the input image
+ * @param[in] frames: number of the frames
+ * @param[in] callback: receiver of the index and the image of each frame
+ * @param[in] period: period of the moving kernel along the streamlines in pixels (L if not positive)
+ */
+inline void licAnimation(cv::InputArray img, const StreamlineCache& cache, int frames,
+                         const LicFrameCallback& callback, double period = 0.0);
+
 inline void angle2vector(cv::InputArray angle, cv::OutputArray vfield, double scale = 1.0);
 
 inline void vector2angle(cv::InputArray vfield, cv::OutputArray angle);
@@ -22,9 +22,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef SRC_NPR_LIC_DETAIL_H_
 #define SRC_NPR_LIC_DETAIL_H_
 
+#include <vector>
 #include <algorithm>
 
 #include "../core/common.hpp"
+#include "../core/FastMath.h"
+#include "../core/Parallel.h"
+#include "../core/Profile.h"
 
 namespace lime {
 
@@ -38,259 +42,892 @@ namespace { // NOLINT
     const double EPS = 1.0e-10;
     const double INF = 1.0e10;
 
+    // * accessor of CV_32FC2 vector fields with the same interface as CompactVectorField
+    class MatVectorField {  // NOLINT
+     public:
+        explicit MatVectorField(const cv::Mat& vfield) : vfield(vfield) {}
+
+        cv::Point2f operator()(int y, int x) const {
+            const float* v = vfield.ptr<float>(y) + x * 2;
+            return cv::Point2f(v[0], v[1]);
+        }
+
+     private:
+        const cv::Mat& vfield;
+    };
+
     bool isLattice(Point2d p) {
         if (sign(floor(p.x) - p.x) == 0 || sign(floor(p.y) - p.y) == 0) return true;
         return false;
     }
 
-    double intkw(double aa, double bb) {
-        return 0.25 * (bb - aa + (sin(bb * cc) - sin(aa * dd)) / cc
-            + (sin(dd * bb + beta) - sin(aa * dd + beta)) / dd
-            + (sin(bb * (cc - dd) - beta) - sin(aa * (cc - dd) - beta)) / (2.0 * (cc - dd))
-            + (sin(bb * (cc + dd) + beta) - sin(aa * (cc + dd) + beta)) / (2.0 * (cc + dd)));
+    // * antiderivatives of the kernel of LIC_CLASSIC, whose integral over [a, b] is kernelUpper(b) - kernelLower(a)
+    double kernelUpper(double t) {
+        return 0.25 * (t + sin(t * cc) / cc + sin(dd * t + beta) / dd
+            + sin(t * (cc - dd) - beta) / (2.0 * (cc - dd))
+            + sin(t * (cc + dd) + beta) / (2.0 * (cc + dd)));
+    }
+
+    double kernelLower(double t) {
+        return 0.25 * (t + sin(t * dd) / cc + sin(dd * t + beta) / dd
+            + sin(t * (cc - dd) - beta) / (2.0 * (cc - dd))
+            + sin(t * (cc + dd) + beta) / (2.0 * (cc + dd)));
     }
 
+    // * samples of the kernel integral tables per unit length
+    const int KERNEL_TABLE_RESOLUTION = 256;
+
+    /* Integral of the kernel of LIC_CLASSIC, whose antiderivatives are tabulated on [0, maxLength] and
+     * interpolated linearly, instead of evaluating 8 sines for every step. The arguments
+     * beyond the tables are evaluated exactly.
+     */
+    class KernelIntegral {  // NOLINT
+     public:
+        explicit KernelIntegral(double maxLength)
+            : size(static_cast<int>(ceil(std::max(maxLength, 0.0) * KERNEL_TABLE_RESOLUTION)) + 2)
+            , upper(size)
+            , lower(size) {
+            for (int i = 0; i < size; i++) {
+                const double t = static_cast<double>(i) / KERNEL_TABLE_RESOLUTION;
+                upper[i] = kernelUpper(t);
+                lower[i] = kernelLower(t);
+            }
+        }
+
+        double operator()(double aa, double bb) const {
+            return lookup(upper, bb, kernelUpper) - lookup(lower, aa, kernelLower);
+        }
+
+     private:
+        double lookup(const std::vector<double>& table, double t, double (*exact)(double)) const {
+            const double u = t * KERNEL_TABLE_RESOLUTION;
+            const int i = static_cast<int>(u);
+            if (u < 0.0 || i >= size - 1) {
+                return exact(t);
+            }
+            const double f = u - i;
+            return table[i] + f * (table[i + 1] - table[i]);
+        }
+
+        int size;
+        std::vector<double> upper, lower;
+    };
+
+    /* Next point where the streamline from pt crosses a pixel boundary. The step is the
+     * shortest positive distance to the boundaries in units of v. While it exceeds 2, which
+     * occurs with short vectors, pt advances by 0.1v, and many of those advances are taken
+     * at once when the boundary ahead is still far.
+     */
     Point2d nextPoint(Point2d pt, Point2d v) {
-        double direct[4];
-        Point2d horz(1.0, 0.0);
-        Point2d vert(0.0, 1.0);
-        direct[0] = (sign(v.det(horz)) == 0) ? INF : (ceil(pt.y) - pt.y) / (abs(v.y) + EPS);    // top
-        direct[1] = (sign(v.det(horz)) == 0) ? INF : (pt.y - floor(pt.y)) / (abs(v.y) + EPS);    // bottom
-        direct[2] = (sign(v.det(vert)) == 0) ? INF : (ceil(pt.x) - pt.x) / (abs(v.x) + EPS);    // left
-        direct[3] = (sign(v.det(vert)) == 0) ? INF : (pt.x - floor(pt.x)) / (abs(v.x) + EPS);    // right
-        double se = INF;
-        for (int i = 0; i < 4; i++) {
-            if (sign(direct[i]) > 0) se = std::min(se, direct[i]);
+        const double rx = 1.0 / (std::abs(v.x) + EPS);
+        const double ry = 1.0 / (std::abs(v.y) + EPS);
+        const bool hasX = sign(v.x) != 0;
+        const bool hasY = sign(v.y) != 0;
+        if (!hasX && !hasY) {
+            return pt + v;
         }
 
-        if (se > 2.0) {
-            Point2d q(pt.x + v.x*0.1, pt.y + v.y*0.1);
-            return nextPoint(q, v);
+        for (;;) {
+            const double fx = floor(pt.x);
+            const double fy = floor(pt.y);
+            const double cx = fx == pt.x ? fx : fx + 1.0;
+            const double cy = fy == pt.y ? fy : fy + 1.0;
+            const double direct[4] = {
+                hasY ? (cy - pt.y) * ry : INF,    // top
+                hasY ? (pt.y - fy) * ry : INF,    // bottom
+                hasX ? (cx - pt.x) * rx : INF,    // left
+                hasX ? (pt.x - fx) * rx : INF     // right
+            };
+            double se = INF;
+            for (int i = 0; i < 4; i++) {
+                if (sign(direct[i]) > 0) se = std::min(se, direct[i]);
+            }
+
+            if (se <= 2.0) {
+                return pt + v * se;
+            }
+
+            // the number of 0.1v advances which keep the boundary ahead beyond 2 in both axes
+            double skip = INF;
+            if (hasX) skip = std::min(skip, (v.x > 0.0 ? direct[2] : direct[3]) - 2.0);
+            if (hasY) skip = std::min(skip, (v.y > 0.0 ? direct[0] : direct[1]) - 2.0);
+            const double k = std::max(1.0, floor(skip * 10.0) - 1.0);
+            pt = pt + v * (0.1 * k);
         }
+    }
 
-        return pt + v * se;
+    // * maximum number of the steps of LIC_CLASSIC in each direction, which are shorter near the lattice
+    const int CLASSIC_MAX_STEPS = 100;
+
+    /* Streamline of LIC_CLASSIC from the pixel (x, y) with the kernel integral kw.
+     * emit(px, py, w, s) is called for every sample at the signed arc length s from the pixel,
+     * which is negative backward, and the number of the steps is returned.
+     */
+    template <class VectorField2f, class Emit>
+    int64_t traceClassic(const VectorField2f& vfield, int width, int height, int x, int y, int L,
+                         const KernelIntegral& kw, const Emit& emit) {
+        int64_t steps = 0;
+        for (int pm = -1; pm <= 1; pm += 2) {
+            double l = 0.0;
+            int cnt = 0;
+            Point2d pt = Point2d(x + 0.5, y + 0.5);
+            while (l < L && cnt++ < CLASSIC_MAX_STEPS) {
+                steps++;
+                int lx = static_cast<int>(ceil(pt.x));
+                int ly = static_cast<int>(ceil(pt.y));
+                if (lx < 0 || ly < 0 || lx >= width || ly >= height) {
+                    break;
+                }
+
+                const cv::Point2f v = vfield(ly, lx);
+                float vx = v.x;
+                float vy = v.y;
+                if (vx == 0.0f && vy == 0.0f) {
+                    break;
+                }
+
+                const Point2d npt = nextPoint(pt, Point2d(pm*vx, pm*vy));
+                const double dx = npt.x - pt.x;
+                const double dy = npt.y - pt.y;
+                const double dl = sqrt(dx * dx + dy * dy);
+                emit(lx, ly, kw(l, l + dl), pm * (l + 0.5 * dl));
+
+                l += dl;
+                pt = npt;
+            }
+        }
+        return steps;
     }
 
-    void lic_classic(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfield, int L) {
-        cv::Mat  img = input.getMat();
-        cv::Mat& out = output.getMatRef();
+    // * number of the seed pixels whose streamlines are traced in lock-step
+    const int LIC_LANES = 8;
+
+    /* Streamlines of LIC_EULARIAN, or LIC_RUNGE_KUTTA if MIDPOINT, from the n <= LIC_LANES
+     * pixels (x0, y), ..., (x0 + n - 1, y). The streamlines advance in lock-step, so that the
+     * dependent loads of the vector field in the different lanes overlap each other, and a lane
+     * is masked out when it leaves the image or reaches a zero vector. The lanes are interleaved
+     * scalar code, which is not vectorized, since they branch apart and each sample is passed to
+     * emit one by one. emit(lane, px, py, w, s) is called for every sample with the weight kernel[l]
+     * of the l-th step and the signed arc length s (see traceClassic), in the same order for each
+     * lane as tracing the streamline alone, and the number of the steps is returned.
+     */
+    template <bool MIDPOINT, class VectorField2f, class Emit>
+    int64_t traceLanes(const VectorField2f& vfield, int width, int height, int x0, int y, int n, int L,
+                       const double* kernel, const Emit& emit) {
+        int64_t steps = 0;
+        for (int pm = -1; pm <= 1; pm += 2) {
+            double ptx[LIC_LANES], pty[LIC_LANES];
+            double tx[LIC_LANES], ty[LIC_LANES];
+            double arc[LIC_LANES];
+            bool active[LIC_LANES];
+            for (int i = 0; i < n; i++) {
+                const cv::Point2f t0 = vfield(y, x0 + i);
+                tx[i] = pm * t0.x;
+                ty[i] = pm * t0.y;
+                ptx[i] = x0 + i + 0.5;
+                pty[i] = y + 0.5;
+                arc[i] = 0.0;
+                active[i] = true;
+            }
 
-        const int width = img.cols;
-        const int height = img.rows;
-        const int dim = img.channels();
-        const int depth = CV_MAKETYPE(CV_32F, dim);
+            bool any = n > 0;
+            for (int l = 1; l < L && any; l++) {
+                any = false;
+                for (int i = 0; i < n; i++) {
+                    if (!active[i]) continue;
+
+                    steps++;
+                    active[i] = false;
+                    int px = static_cast<int>(ceil(ptx[i]));
+                    int py = static_cast<int>(ceil(pty[i]));
+                    if (px < 0 || py < 0 || px >= width || py >= height) {
+                        continue;
+                    }
 
-        out = cv::Mat::zeros(height, width, depth);
-        for (int it = 1; it <= 2; it++) {
-            ompfor(int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    double weight = 0.0;
-                    for (int c = 0; c < dim; c++) {
-                        out.at<float>(y, x*dim + c) = 0.0f;
+                    if (MIDPOINT) {
+                        emit(i, px, py, kernel[l], pm * arc[i]);
                     }
 
-                    for (int pm = -1; pm <= 1; pm += 2) {
-                        double l = 0.0;
-                        int cnt = 0;
-                        Point2d pt = Point2d(x + 0.5, y + 0.5);
-                        while (l < L && cnt++ < 100) {
-                            int lx = static_cast<int>(ceil(pt.x));
-                            int ly = static_cast<int>(ceil(pt.y));
-                            if (lx < 0 || ly < 0 || lx >= width || ly >= height) {
-                                break;
-                            }
-
-                            float vx = vfield.at<float>(ly, lx * 2 + 0);
-                            float vy = vfield.at<float>(ly, lx * 2 + 1);
-                            if (vx == 0.0f && vy == 0.0f) {
-                                break;
-                            }
-
-                            Point2d npt = nextPoint(pt, Point2d(pm*vx, pm*vy));
-                            double dl = (pt - npt).norm();
-                            double h = intkw(l, l + dl);
-                            for (int c = 0; c < dim; c++) {
-                                out.at<float>(y, x*dim + c) += img.at<float>(ly, lx*dim + c) * static_cast<float>(h);
-                            }
-                            weight += h;
-
-                            l += dl;
-                            pt = npt;
-                        }
+                    cv::Point2f v = vfield(py, px);
+                    if (v.x == 0.0f && v.y == 0.0f) {
+                        continue;
                     }
 
-                    for (int c = 0; c < dim; c++) {
-                        if (weight != 0.0) {
-                            out.at<float>(y, x*dim + c) = out.at<float>(y, x*dim + c) / static_cast<float>(weight);
-                        } else {
-                            out.at<float>(y, x*dim + c) = img.at<float>(y, x*dim + c);
+                    if (MIDPOINT) {
+                        const double inner = v.x * tx[i] + v.y * ty[i];
+                        const double sx = sign(inner) * v.x;
+                        const double sy = sign(inner) * v.y;
+                        px = static_cast<int>(ceil(ptx[i] + 0.5 * sx));
+                        py = static_cast<int>(ceil(pty[i] + 0.5 * sy));
+                        if (px < 0 || py < 0 || px >= width || py >= height) {
+                            continue;
                         }
+                        v = vfield(py, px);
+                    } else {
+                        emit(i, px, py, kernel[l], pm * arc[i]);
                     }
+
+                    const double inner = v.x * tx[i] + v.y * ty[i];
+                    tx[i] = sign(inner) * v.x;
+                    ty[i] = sign(inner) * v.y;
+                    ptx[i] += tx[i];
+                    pty[i] += ty[i];
+                    arc[i] += sqrt(tx[i] * tx[i] + ty[i] * ty[i]);
+                    active[i] = true;
+                    any = true;
                 }
             }
-            out.convertTo(img, depth);
         }
+        return steps;
     }
 
-    void lic_eularian(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfield, int L) {
+    // * rows of the strips in which FastLIC seeds streamlines independently
+    const int FAST_LIC_STRIP = 32;
+
+    // * pixels are seeded until they are covered by this number of streamlines
+    const int FAST_LIC_MIN_HITS = 2;
+
+    // * length of the streamlines traced by FastLIC in multiples of L
+    const int FAST_LIC_LENGTH = 10;
+
+    /* FastLIC (Stalling and Hege 1995). A long streamline is traced from every
+     * pixel which is not yet covered enough, and the box filter of length 2L+1
+     * is applied to all of its samples with the prefix sums, so that the pixels
+     * on the streamline get their results at once. The image is split into
+     * strips of fixed height processed in parallel, each of which writes only
+     * its own pixels, so that the result does not depend on the number of threads.
+     */
+    template <class VectorField2f>
+    void lic_fast(cv::InputArray input, cv::OutputArray output, const VectorField2f& vfield, int L) {
+        LIME_PROFILE_SCOPE("lic_fast");
         cv::Mat  img = input.getMat();
         cv::Mat& out = output.getMatRef();
 
         const int width = img.cols;
         const int height = img.rows;
         const int dim = img.channels();
-        const int depth = CV_MAKETYPE(CV_32F, dim);
-        const double sigma = 32.0;
+        const int maxSteps = FAST_LIC_LENGTH * std::max(L, 1);
+
+        out = cv::Mat::zeros(height, width, CV_MAKETYPE(CV_32F, dim));
+        std::vector<int> hits(width * height, 0);
+
+        const int nStrips = (height + FAST_LIC_STRIP - 1) / FAST_LIC_STRIP;
+        parallel_for(0, nStrips, [&](int strip) {
+            const int y0 = strip * FAST_LIC_STRIP;
+            const int y1 = std::min(height, y0 + FAST_LIC_STRIP);
+
+            std::vector<cv::Point> forward, backward, samples;
+            std::vector<double> prefix;
+            int64_t steps = 0;
+
+            // samples in one direction until the streamline leaves the image, reaches
+            // a zero vector, or stays outside of the strip longer than the kernel,
+            // and whether it is cut at the maximum length instead
+            auto trace = [&](int x, int y, int pm, std::vector<cv::Point>* line) {
+                line->clear();
+                const cv::Point2f v0 = vfield(y, x);
+                double tx = pm * v0.x;
+                double ty = pm * v0.y;
+                Point2d pt(x + 0.5, y + 0.5);
+                int outside = 0;
+                int k = 0;
+                for (; k < maxSteps && outside <= L; k++) {
+                    steps++;
+                    pt.x += tx;
+                    pt.y += ty;
+                    const int px = static_cast<int>(floor(pt.x));
+                    const int py = static_cast<int>(floor(pt.y));
+                    if (px < 0 || py < 0 || px >= width || py >= height) {
+                        break;
+                    }
+
+                    const cv::Point2f v = vfield(py, px);
+                    if (v.x == 0.0f && v.y == 0.0f) {
+                        break;
+                    }
+                    line->push_back(cv::Point(px, py));
+                    outside = py >= y0 && py < y1 ? 0 : outside + 1;
+
+                    const double inner = v.x * tx + v.y * ty;
+                    tx = inner < 0.0 ? -v.x : v.x;
+                    ty = inner < 0.0 ? -v.y : v.y;
+                }
+                return k == maxSteps;
+            };
 
-        out = cv::Mat::zeros(height, width, depth);
-        for (int it = 1; it <= 3; it++) {
-            ompfor(int y = 0; y < height; y++) {
+            for (int y = y0; y < y1; y++) {
                 for (int x = 0; x < width; x++) {
-                    double weight = 0.0;
-                    for (int c = 0; c < dim; c++) {
-                        out.at<float>(y, x*dim + c) = 0.0f;
+                    if (hits[y * width + x] >= FAST_LIC_MIN_HITS) continue;
+
+                    const cv::Point2f v0 = vfield(y, x);
+                    bool cutBackward = false;
+                    bool cutForward = false;
+                    if (v0.x == 0.0f && v0.y == 0.0f) {
+                        backward.clear();
+                        forward.clear();
+                    } else {
+                        cutBackward = trace(x, y, -1, &backward);
+                        cutForward = trace(x, y, 1, &forward);
                     }
 
-                    for (int pm = -1; pm <= 1; pm += 2) {
-                        int l = 0;
-                        double tx = pm * vfield.at<float>(y, x * 2 + 0);
-                        double ty = pm * vfield.at<float>(y, x * 2 + 1);
-                        Point2d pt = Point2d(x + 0.5, y + 0.5);
-                        while (++l < L) {
-                            int px = static_cast<int>(ceil(pt.x));
-                            int py = static_cast<int>(ceil(pt.y));
-                            if (px < 0 || py < 0 || px >= width || py >= height) {
-                                break;
-                            }
-
-                            double vx = vfield.at<float>(py, px * 2 + 0);
-                            double vy = vfield.at<float>(py, px * 2 + 1);
-                            if (vx == 0.0f && vy == 0.0f) {
-                                break;
-                            }
-
-                            double w = exp(-l * l / sigma);
-                            for (int c = 0; c < dim; c++) {
-                                out.at<float>(y, x*dim + c) += static_cast<float>(w * img.at<float>(py, px*dim + c));
-                            }
-                            weight += w;
-
-                            double inner = vx * tx + vy * ty;
-                            tx = sign(inner) * vx;
-                            ty = sign(inner) * vy;
-                            pt.x += tx;
-                            pt.y += ty;
+                    samples.assign(backward.rbegin(), backward.rend());
+                    samples.push_back(cv::Point(x, y));
+                    samples.insert(samples.end(), forward.begin(), forward.end());
+
+                    const int n = static_cast<int>(samples.size());
+                    prefix.assign((n + 1) * dim, 0.0);
+                    for (int i = 0; i < n; i++) {
+                        const float* p = img.ptr<float>(samples[i].y) + samples[i].x * dim;
+                        for (int c = 0; c < dim; c++) {
+                            prefix[(i + 1) * dim + c] = prefix[i * dim + c] + p[c];
                         }
                     }
 
-                    for (int c = 0; c < dim; c++) {
-                        if (weight != 0.0) {
-                            out.at<float>(y, x*dim + c) = out.at<float>(y, x*dim + c) / static_cast<float>(weight);
-                        } else {
-                            out.at<float>(y, x*dim + c) = img.at<float>(y, x*dim + c);
+                    // the samples near a cut end are left to the streamlines seeded later,
+                    // since their kernels would be truncated (maxSteps >= L keeps the seed)
+                    const int first = cutBackward ? L : 0;
+                    const int last = cutForward ? n - 1 - L : n - 1;
+                    for (int i = first; i <= last; i++) {
+                        const cv::Point& q = samples[i];
+                        if (q.y < y0 || q.y >= y1) continue;
+
+                        const int lo = std::max(0, i - L);
+                        const int hi = std::min(n - 1, i + L);
+                        const double norm = 1.0 / (hi - lo + 1);
+                        float* o = out.ptr<float>(q.y) + q.x * dim;
+                        for (int c = 0; c < dim; c++) {
+                            o[c] += static_cast<float>((prefix[(hi + 1) * dim + c] - prefix[lo * dim + c]) * norm);
                         }
+                        hits[q.y * width + q.x]++;
+                    }
+                }
+            }
+
+            for (int y = y0; y < y1; y++) {
+                float* o = out.ptr<float>(y);
+                for (int x = 0; x < width; x++) {
+                    const float inv = 1.0f / hits[y * width + x];
+                    for (int c = 0; c < dim; c++) {
+                        o[x * dim + c] *= inv;
                     }
                 }
             }
-            out.convertTo(img, depth);
+            LIME_PROFILE_COUNT("steps", steps);
+        }, 1);
+    }
+
+    // * sigma of the Gaussian weights of LIC_EULARIAN and LIC_RUNGE_KUTTA
+    const double LIC_SIGMA = 32.0;
+
+    // * entries of the table of cos and sin over a period of the ripple of animated LIC (power of 2)
+    const int LIC_RIPPLE_TABLE = 4096;
+
+    // * memory of the streamlines which lic caches for its iterations, beyond which they are traced again
+    const size_t LIC_CACHE_BUDGET = size_t(256) << 20;
+
+    int licIterations(LicAlgo algo_type) {
+        return algo_type == LIC_CLASSIC ? 2 : 3;
+    }
+
+    // * upper bound of the samples on the streamline of a pixel
+    size_t licMaxSamples(LicAlgo algo_type, int L) {
+        return algo_type == LIC_CLASSIC ? 2 * CLASSIC_MAX_STEPS : 2 * std::max(L, 1);
+    }
+
+    // * range of the kernel integral beyond L, which covers the last steps of the vectors up to length 2
+    const double CLASSIC_TABLE_MARGIN = 4.0;
+
+    /* Tracer of the streamlines with the step rule of ALGO, which is LIC_CLASSIC,
+     * LIC_EULARIAN or LIC_RUNGE_KUTTA. The Gaussian weights of the steps, or the kernel integral of
+     * LIC_CLASSIC, are tabulated.
+     */
+    template <class VectorField2f, LicAlgo ALGO>
+    class LicTracer {  // NOLINT
+     public:
+        LicTracer(const VectorField2f& vfield, int width, int height, int L)
+            : vfield(vfield), width(width), height(height), L(L), kernel(std::max(L, 1))
+            , kw(ALGO == LIC_CLASSIC ? L + CLASSIC_TABLE_MARGIN : 0.0) {
+            for (int l = 0; l < L; l++) {
+                kernel[l] = exp(-l * l / LIC_SIGMA);
+            }
+        }
+
+        // * streamlines of the n <= LIC_LANES pixels from (x0, y) (see traceLanes)
+        template <class Emit>
+        int64_t operator()(int x0, int y, int n, const Emit& emit) const {
+            if (ALGO != LIC_CLASSIC) {
+                return traceLanes<ALGO == LIC_RUNGE_KUTTA>(vfield, width, height, x0, y, n, L, &kernel[0], emit);
+            }
+
+            int64_t steps = 0;
+            for (int i = 0; i < n; i++) {
+                steps += traceClassic(vfield, width, height, x0 + i, y, L, kw,
+                    [&](int px, int py, double w, double s) {
+                    emit(i, px, py, w, s);
+                });
+            }
+            return steps;
         }
+
+     private:
+        const VectorField2f& vfield;
+        int width, height, L;
+        std::vector<double> kernel;
+        KernelIntegral kw;
+    };
+
+    // * position of the algorithm in the dispatch tables, which are ordered as LicAlgo
+    int tracerIndex(LicAlgo algo_type) {
+        msg_check(algo_type == LIC_CLASSIC || algo_type == LIC_EULARIAN || algo_type == LIC_RUNGE_KUTTA,
+            "Streamlines can be traced only with LIC_CLASSIC, LIC_EULARIAN or LIC_RUNGE_KUTTA.");
+        return algo_type - LIC_CLASSIC;
     }
 
-    void lic_runge_kutta(cv::InputArray input, cv::OutputArray output, const cv::Mat& vfield, int L) {
-        cv::Mat  img = input.getMat();
-        cv::Mat& out = output.getMatRef();
+    // * check the input image and copy it as a floating-point image
+    cv::Mat licInput(cv::InputArray img) {
+        msg_assert(img.depth() == CV_32F, "Input image must be floating-point-valued.");
+        msg_check(img.channels() >= 1 && img.channels() <= 4, "Input image must have 1 to 4 channels");
 
-        const int width = img.cols;
-        const int height = img.rows;
-        const int dim = img.channels();
-        const int depth = CV_MAKETYPE(CV_32F, dim);
-        const double sigma = 32.0;
+        cv::Mat tmp;
+        img.getMat().convertTo(tmp, CV_32F);
+        return tmp;
+    }
 
-        out = cv::Mat::zeros(height, width, depth);
-        for (int it = 1; it <= 3; it++) {
-            ompfor(int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    double weight = 0.0;
-                    for (int c = 0; c < dim; c++) {
-                        out.at<float>(y, x*dim + c) = 0.0f;
+    // * one iteration of LIC of DIM channels which traces the streamlines of all the pixels
+    template <int DIM, class Tracer>
+    void licTracedPass(const Tracer& trace, const cv::Mat& img, cv::Mat* out) {
+        parallel_for(0, img.rows, [&](int y) {
+            int64_t steps = 0;
+            const float* src = img.ptr<float>(y);
+            float* o = out->ptr<float>(y);
+            for (int x0 = 0; x0 < img.cols; x0 += LIC_LANES) {
+                const int n = std::min(LIC_LANES, img.cols - x0);
+                float acc[LIC_LANES][DIM] = {};
+                double weight[LIC_LANES] = {};
+                steps += trace(x0, y, n, [&](int i, int px, int py, double w, double) {
+                    const float* p = img.ptr<float>(py) + px * DIM;
+                    const float wf = static_cast<float>(w);
+                    for (int c = 0; c < DIM; c++) {
+                        acc[i][c] += wf * p[c];
+                    }
+                    weight[i] += w;
+                });
+
+                for (int i = 0; i < n; i++) {
+                    const int x = x0 + i;
+                    const float wf = static_cast<float>(weight[i]);
+                    for (int c = 0; c < DIM; c++) {
+                        o[x * DIM + c] = weight[i] != 0.0 ? acc[i][c] / wf : src[x * DIM + c];
                     }
+                }
+            }
+            LIME_PROFILE_COUNT("steps", steps);
+        });
+    }
 
-                    for (int pm = -1; pm <= 1; pm += 2) {
-                        int l = 0;
-                        double tx = pm * vfield.at<float>(y, x * 2 + 0);
-                        double ty = pm * vfield.at<float>(y, x * 2 + 1);
-                        Point2d pt = Point2d(x + 0.5, y + 0.5);
-                        while (++l < L) {
-                            int px = static_cast<int>(ceil(pt.x));
-                            int py = static_cast<int>(ceil(pt.y));
-                            if (px < 0 || py < 0 || px >= width || py >= height) {
-                                break;
-                            }
-
-                            double w = exp(-l * l / sigma);
-                            for (int c = 0; c < dim; c++) {
-                                out.at<float>(y, x*dim + c) += static_cast<float>(w * img.at<float>(py, px*dim + c));
-                            }
-                            weight += w;
-
-                            double vx = vfield.at<float>(py, px * 2 + 0);
-                            double vy = vfield.at<float>(py, px * 2 + 1);
-                            if (vx == 0.0f && vy == 0.0f) {
-                                break;
-                            }
-
-                            double inner = vx * tx + vy * ty;
-                            double sx = sign(inner) * vx;
-                            double sy = sign(inner) * vy;
-                            px = static_cast<int>(ceil(pt.x + 0.5 * sx));
-                            py = static_cast<int>(ceil(pt.y + 0.5 * sy));
-                            if (px < 0 || py < 0 || px >= width || py >= height) {
-                                break;
-                            }
-
-                            vx = vfield.at<float>(py, px * 2 + 0);
-                            vy = vfield.at<float>(py, px * 2 + 1);
-                            inner = vx * tx + vy * ty;
-                            tx = sign(inner) * vx;
-                            ty = sign(inner) * vy;
-                            pt.x += tx;
-                            pt.y += ty;
-                        }
+    /* LIC which traces the streamlines in every iteration, for the images of which
+     * the streamlines do not fit in LIC_CACHE_BUDGET.
+     */
+    template <class VectorField2f, LicAlgo ALGO>
+    void lic_traced(cv::Mat* img, cv::Mat* out, const VectorField2f& vfield, int L) {
+        LIME_PROFILE_SCOPE("lic_traced");
+        typedef LicTracer<VectorField2f, ALGO> Tracer;
+        typedef void (*Pass)(const Tracer&, const cv::Mat&, cv::Mat*);
+        static const Pass passes[] = {
+            NULL, licTracedPass<1, Tracer>, licTracedPass<2, Tracer>, licTracedPass<3, Tracer>,
+            licTracedPass<4, Tracer>
+        };
+        msg_check(img->channels() >= 1 && img->channels() <= 4, "Input image must have 1 to 4 channels");
+
+        const int iterations = licIterations(ALGO);
+        const Tracer trace(vfield, img->cols, img->rows, L);
+        LIME_PROFILE_COUNT("iterations", iterations);
+
+        cv::Mat next(img->size(), img->type());
+        for (int it = 1; it <= iterations; it++) {
+            passes[img->channels()](trace, *img, &next);
+            std::swap(*img, next);
+        }
+        *out = *img;
+    }
+
+    /* Trace the streamlines of all the pixels into the compressed sparse rows
+     * @param[out] offsets: first sample of each pixel, followed by the number of the samples
+     * @param[out] indices: linear pixel indices of the samples
+     * @param[out] weights: kernel weights of the samples
+     * @param[out] positions: signed arc lengths of the samples along the streamlines
+     * @param[out] totals: sum of the weights of each pixel
+     */
+    template <class VectorField2f, LicAlgo ALGO>
+    void traceStreamlines(const VectorField2f& tangent, int rows, int cols, int length,
+                          std::vector<size_t>* offsetsPtr, std::vector<int>* indicesPtr,
+                          std::vector<float>* weightsPtr, std::vector<float>* positionsPtr,
+                          std::vector<float>* totalsPtr) {
+        LIME_PROFILE_SCOPE("trace_streamlines");
+        const LicTracer<VectorField2f, ALGO> tracer(tangent, cols, rows, length);
+        std::vector<size_t>& offsets = *offsetsPtr;
+        std::vector<int>& indices = *indicesPtr;
+        std::vector<float>& weights = *weightsPtr;
+        std::vector<float>& positions = *positionsPtr;
+        std::vector<float>& totals = *totalsPtr;
+
+        // Each row is traced into its own buffers, which are then packed into the CSR arrays.
+        std::vector<std::vector<int> > rowIndices(rows);
+        std::vector<std::vector<float> > rowWeights(rows);
+        std::vector<std::vector<float> > rowPositions(rows);
+        std::vector<size_t> rowSamples(rows + 1, 0);
+        offsets.assign(size_t(rows) * cols + 1, 0);
+        totals.assign(size_t(rows) * cols, 0.0f);
+        parallel_for(0, rows, [&](int y) {
+            std::vector<int>& idx = rowIndices[y];
+            std::vector<float>& wgt = rowWeights[y];
+            std::vector<float>& pos = rowPositions[y];
+            idx.reserve(size_t(cols) * 2 * std::max(length, 1));
+            wgt.reserve(idx.capacity());
+            pos.reserve(idx.capacity());
+
+            // the samples of the lanes are interleaved, and are appended to the row lane by lane
+            std::vector<int> laneIdx[LIC_LANES];
+            std::vector<float> laneWgt[LIC_LANES];
+            std::vector<float> lanePos[LIC_LANES];
+            int64_t steps = 0;
+            for (int x0 = 0; x0 < cols; x0 += LIC_LANES) {
+                const int n = std::min(LIC_LANES, cols - x0);
+                double weight[LIC_LANES] = {};
+                steps += tracer(x0, y, n, [&](int i, int px, int py, double w, double s) {
+                    laneIdx[i].push_back(py * cols + px);
+                    laneWgt[i].push_back(static_cast<float>(w));
+                    lanePos[i].push_back(static_cast<float>(s));
+                    weight[i] += w;
+                });
+
+                for (int i = 0; i < n; i++) {
+                    const int x = x0 + i;
+                    idx.insert(idx.end(), laneIdx[i].begin(), laneIdx[i].end());
+                    wgt.insert(wgt.end(), laneWgt[i].begin(), laneWgt[i].end());
+                    pos.insert(pos.end(), lanePos[i].begin(), lanePos[i].end());
+                    laneIdx[i].clear();
+                    laneWgt[i].clear();
+                    lanePos[i].clear();
+                    offsets[size_t(y) * cols + x + 1] = idx.size();
+                    totals[size_t(y) * cols + x] = static_cast<float>(weight[i]);
+                }
+            }
+            rowSamples[y + 1] = idx.size();
+            LIME_PROFILE_COUNT("steps", steps);
+        });
+
+        for (int y = 0; y < rows; y++) {
+            rowSamples[y + 1] += rowSamples[y];
+        }
+        indices.resize(rowSamples[rows]);
+        weights.resize(rowSamples[rows]);
+        positions.resize(rowSamples[rows]);
+        parallel_for(0, rows, [&](int y) {
+            const size_t base = rowSamples[y];
+            std::copy(rowIndices[y].begin(), rowIndices[y].end(), indices.begin() + base);
+            std::copy(rowWeights[y].begin(), rowWeights[y].end(), weights.begin() + base);
+            std::copy(rowPositions[y].begin(), rowPositions[y].end(), positions.begin() + base);
+            for (int x = 1; x <= cols; x++) {
+                offsets[size_t(y) * cols + x] += base;
+            }
+            std::vector<int>().swap(rowIndices[y]);
+            std::vector<float>().swap(rowWeights[y]);
+            std::vector<float>().swap(rowPositions[y]);
+        });
+        LIME_PROFILE_COUNT("samples", static_cast<int64_t>(indices.size()));
+    }
+
+    // * dispatch of traceStreamlines to the step rule of the algorithm
+    template <class VectorField2f>
+    void traceStreamlines(const VectorField2f& tangent, int rows, int cols, int length, LicAlgo algo_type,
+                          std::vector<size_t>* offsets, std::vector<int>* indices,
+                          std::vector<float>* weights, std::vector<float>* positions, std::vector<float>* totals) {
+        typedef void (*Trace)(const VectorField2f&, int, int, int, std::vector<size_t>*, std::vector<int>*,
+                              std::vector<float>*, std::vector<float>*, std::vector<float>*);
+        static const Trace traces[] = {
+            traceStreamlines<VectorField2f, LIC_CLASSIC>,
+            traceStreamlines<VectorField2f, LIC_EULARIAN>,
+            traceStreamlines<VectorField2f, LIC_RUNGE_KUTTA>
+        };
+        traces[tracerIndex(algo_type)](tangent, rows, cols, length, offsets, indices, weights, positions, totals);
+    }
+
+    // * one iteration of LIC of DIM channels along the streamlines stored in the compressed sparse rows
+    template <int DIM>
+    void gatherStreamlines(const cv::Mat& input, cv::Mat* output, const size_t* offsets, const int* indices,
+                           const float* weights, const float* totals) {
+        const float* src = input.ptr<float>(0);
+        parallel_for(0, input.rows, [&](int y) {
+            float* o = output->ptr<float>(y);
+            for (int x = 0; x < input.cols; x++) {
+                const size_t i = size_t(y) * input.cols + x;
+                if (totals[i] == 0.0f) {
+                    for (int c = 0; c < DIM; c++) {
+                        o[x * DIM + c] = src[i * DIM + c];
                     }
+                    continue;
+                }
 
-                    for (int c = 0; c < dim; c++) {
-                        if (weight != 0.0) {
-                            out.at<float>(y, x*dim + c) = out.at<float>(y, x*dim + c) / static_cast<float>(weight);
-                        } else {
-                            out.at<float>(y, x*dim + c) = img.at<float>(y, x*dim + c);
-                        }
+                float acc[DIM] = {};
+                for (size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                    const float* p = src + size_t(indices[k]) * DIM;
+                    const float w = weights[k];
+                    for (int c = 0; c < DIM; c++) {
+                        acc[c] += w * p[c];
+                    }
+                }
+
+                const float inv = 1.0f / totals[i];
+                for (int c = 0; c < DIM; c++) {
+                    o[x * DIM + c] = acc[c] * inv;
+                }
+            }
+        });
+    }
+
+    /* Sums of the samples of DIM channels for animated LIC. Since cos(t + p) = cos(t) cos(p) - sin(t) sin(p),
+     * each pixel keeps the samples weighted by 1, cos(t) and sin(t) of the ripple phase t, followed by
+     * the sum of the weights, in 3 blocks of DIM + 1 values.
+     */
+    template <int DIM>
+    void gatherRipple(const cv::Mat& input, const size_t* offsets, const int* indices, const float* weights,
+                      const float* positions, float scale, const float* ripple, float* sums) {
+        const float* src = input.ptr<float>(0);
+        parallel_for(0, input.rows, [&](int y) {
+            for (int x = 0; x < input.cols; x++) {
+                const size_t i = size_t(y) * input.cols + x;
+                float plain[DIM] = {}, cosine[DIM] = {}, sine[DIM] = {};
+                float wp = 0.0f, wc = 0.0f, ws = 0.0f;
+                for (size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                    const float u = positions[k] * scale;
+                    const int j = static_cast<int>(u + (u >= 0.0f ? 0.5f : -0.5f)) & (LIC_RIPPLE_TABLE - 1);
+                    const float w = weights[k];
+                    const float c = w * ripple[j * 2 + 0];
+                    const float s = w * ripple[j * 2 + 1];
+                    const float* p = src + size_t(indices[k]) * DIM;
+                    for (int d = 0; d < DIM; d++) {
+                        plain[d] += w * p[d];
+                        cosine[d] += c * p[d];
+                        sine[d] += s * p[d];
                     }
+                    wp += w;
+                    wc += c;
+                    ws += s;
+                }
+
+                float* sum = sums + i * 3 * (DIM + 1);
+                for (int d = 0; d < DIM; d++) {
+                    sum[d] = plain[d];
+                    sum[(DIM + 1) + d] = cosine[d];
+                    sum[2 * (DIM + 1) + d] = sine[d];
                 }
+                sum[DIM] = wp;
+                sum[(DIM + 1) + DIM] = wc;
+                sum[2 * (DIM + 1) + DIM] = ws;
             }
-            out.convertTo(img, depth);
+        });
+    }
+
+    // * frame of animated LIC of DIM channels with the ripple phase shifted by p, where cp = cos(p) and sp = sin(p)
+    template <int DIM>
+    void blendRipple(const cv::Mat& input, const float* sums, float cp, float sp, cv::Mat* frame) {
+        const float* src = input.ptr<float>(0);
+        parallel_for(0, input.rows, [&](int y) {
+            float* o = frame->ptr<float>(y);
+            for (int x = 0; x < input.cols; x++) {
+                const size_t i = size_t(y) * input.cols + x;
+                const float* plain = sums + i * 3 * (DIM + 1);
+                const float* cosine = plain + (DIM + 1);
+                const float* sine = plain + 2 * (DIM + 1);
+                const float total = plain[DIM] + cp * cosine[DIM] - sp * sine[DIM];
+                for (int c = 0; c < DIM; c++) {
+                    if (total > 1.0e-4f * plain[DIM]) {
+                        o[x * DIM + c] = (plain[c] + cp * cosine[c] - sp * sine[c]) / total;
+                    } else if (plain[DIM] != 0.0f) {
+                        // the ripple has cancelled all the samples
+                        o[x * DIM + c] = plain[c] / plain[DIM];
+                    } else {
+                        o[x * DIM + c] = src[i * DIM + c];
+                    }
+                }
+            }
+        });
+    }
+
+    // * dispatch of lic_traced to the step rule of the algorithm
+    template <class VectorField2f>
+    void licTraced(cv::Mat* img, cv::Mat* out, const VectorField2f& vfield, int L, LicAlgo algo_type) {
+        typedef void (*Lic)(cv::Mat*, cv::Mat*, const VectorField2f&, int);
+        static const Lic lics[] = {
+            lic_traced<VectorField2f, LIC_CLASSIC>,
+            lic_traced<VectorField2f, LIC_EULARIAN>,
+            lic_traced<VectorField2f, LIC_RUNGE_KUTTA>
+        };
+        lics[tracerIndex(algo_type)](img, out, vfield, L);
+    }
+
+    // * accessors to the vectors used by the kernels
+    MatVectorField fieldAccessor(const cv::Mat& vfield) {
+        return MatVectorField(vfield);
+    }
+
+    const CompactVectorField& fieldAccessor(const CompactVectorField& vfield) {
+        return vfield;
+    }
+
+    // * iterations of LIC along the cached streamlines, which overwrite the input image
+    void licWithCache(cv::Mat* img, cv::Mat* out, const StreamlineCache& cache) {
+        LIME_PROFILE_COUNT("iterations", cache.iterations());
+        cv::Mat next;
+        for (int it = 1; it <= cache.iterations(); it++) {
+            cache.convolve(*img, &next);
+            std::swap(*img, next);
+        }
+        *out = *img;
+    }
+
+    template <class VectorField>
+    void licWithField(cv::OutputArray out, cv::InputArray img, const VectorField& vfield, int L, LicAlgo algo_type) {
+        LIME_PROFILE_SCOPE("lic");
+        LIME_PROFILE_COUNT("pixels", img.rows() * img.cols());
+        cv::Mat  tmp = licInput(img);
+        cv::Mat& outRef = out.getMatRef();
+
+        if (algo_type == LIC_FAST) {
+            lic_fast(tmp, outRef, fieldAccessor(vfield), L);
+            return;
+        }
+
+        // The streamlines are cached and shared by the iterations unless they are too large.
+        // The samples of 12 bytes are counted twice, since traceStreamlines keeps the buffers
+        // of the rows until they are packed into the cache.
+        const size_t pixels = size_t(tmp.rows) * tmp.cols;
+        const size_t sampleBytes = sizeof(int) + 2 * sizeof(float);
+        const size_t bytes = pixels * (2 * licMaxSamples(algo_type, L) * sampleBytes + sizeof(size_t) + sizeof(float));
+        if (bytes <= LIC_CACHE_BUDGET) {
+            licWithCache(&tmp, &outRef, StreamlineCache(vfield, L, algo_type));
+        } else {
+            licTraced(&tmp, &outRef, fieldAccessor(vfield), L, algo_type);
         }
     }
 
 } /* unnamed namespace */
 
-    void lic(cv::OutputArray out, cv::InputArray img, const cv::Mat& vfield, int L, LicAlgo algo_type) {
-        msg_assert(img.depth() == CV_32F, "Input image must be floating-point-valued.");
-        msg_assert(img.channels() == 1 || img.channels() == 3, "Input image must have 1 or 3 channels");
+    inline StreamlineCache::StreamlineCache()
+        : nrows(0)
+        , ncols(0)
+        , L(0)
+        , algo(LIC_EULARIAN)
+        , offsets(1, 0) {
+    }
 
-        cv::Mat  tmp;
-        img.getMat().convertTo(tmp, CV_32F);
+    inline StreamlineCache::StreamlineCache(const cv::Mat& tangent, int L, LicAlgo algo_type)
+        : nrows(tangent.rows)
+        , ncols(tangent.cols)
+        , L(L)
+        , algo(algo_type) {
+        msg_assert(tangent.depth() == CV_32F && tangent.channels() == 2, "Format of input vector field is invalid.");
+        msg_check(algo_type != LIC_FAST, "LIC_FAST does not trace the streamlines of the pixels to be cached.");
+        traceStreamlines(MatVectorField(tangent), nrows, ncols, L, algo,
+                         &offsets, &indices, &weights, &positions, &totals);
+    }
 
-        cv::Mat& outRef = out.getMatRef();
+    inline StreamlineCache::StreamlineCache(const CompactVectorField& tangent, int L, LicAlgo algo_type)
+        : nrows(tangent.rows())
+        , ncols(tangent.cols())
+        , L(L)
+        , algo(algo_type) {
+        msg_check(algo_type != LIC_FAST, "LIC_FAST does not trace the streamlines of the pixels to be cached.");
+        traceStreamlines(tangent, nrows, ncols, L, algo, &offsets, &indices, &weights, &positions, &totals);
+    }
+
+    int StreamlineCache::iterations() const {
+        return licIterations(algo);
+    }
 
-        if (algo_type == LIC_CLASSIC) {
-            lic_classic(tmp, outRef, vfield, L);
-        } else if (algo_type == LIC_EULARIAN) {
-            lic_eularian(tmp, outRef, vfield, L);
-        } else if (algo_type == LIC_RUNGE_KUTTA) {
-            lic_runge_kutta(tmp, outRef, vfield, L);
+    void StreamlineCache::convolve(const cv::Mat& input, cv::Mat* output) const {
+        msg_assert(input.rows == nrows && input.cols == ncols, "Input image must have the size of the streamlines.");
+        msg_assert(input.depth() == CV_32F && input.isContinuous(),
+            "Input image must be a continuous floating-point image.");
+        msg_check(input.channels() >= 1 && input.channels() <= 4, "Input image must have 1 to 4 channels");
+        msg_assert(output != NULL && output->data != input.data, "Output image must differ from the input image.");
+
+        typedef void (*Gather)(const cv::Mat&, cv::Mat*, const size_t*, const int*, const float*, const float*);
+        static const Gather gathers[] = {
+            NULL, gatherStreamlines<1>, gatherStreamlines<2>, gatherStreamlines<3>, gatherStreamlines<4>
+        };
+
+        output->create(nrows, ncols, input.type());
+        gathers[input.channels()](input, output, &offsets[0], indices.data(), weights.data(), totals.data());
+    }
+
+    void StreamlineCache::animate(const cv::Mat& input, int frames, double period,
+                                  const LicFrameCallback& callback) const {
+        LIME_PROFILE_SCOPE("lic_animation");
+        msg_assert(input.rows == nrows && input.cols == ncols, "Input image must have the size of the streamlines.");
+        msg_assert(input.depth() == CV_32F && input.isContinuous(),
+            "Input image must be a continuous floating-point image.");
+        msg_check(input.channels() >= 1 && input.channels() <= 4, "Input image must have 1 to 4 channels");
+        msg_assert(frames > 0 && period > 0.0, "Number of frames and period must be positive.");
+
+        typedef void (*Gather)(const cv::Mat&, const size_t*, const int*, const float*, const float*,
+                               float, const float*, float*);
+        typedef void (*Blend)(const cv::Mat&, const float*, float, float, cv::Mat*);
+        static const Gather gathers[] = {
+            NULL, gatherRipple<1>, gatherRipple<2>, gatherRipple<3>, gatherRipple<4>
+        };
+        static const Blend blends[] = {
+            NULL, blendRipple<1>, blendRipple<2>, blendRipple<3>, blendRipple<4>
+        };
+
+        // cos(t) and sin(t) are looked up from the table over a period with the rounded arc lengths
+        std::vector<float> ripple(2 * LIC_RIPPLE_TABLE);
+        for (int j = 0; j < LIC_RIPPLE_TABLE; j++) {
+            const double t = 2.0 * PI * j / LIC_RIPPLE_TABLE;
+            ripple[j * 2 + 0] = static_cast<float>(cos(t));
+            ripple[j * 2 + 1] = static_cast<float>(sin(t));
+        }
+
+        const int dim = input.channels();
+        const float scale = static_cast<float>(LIC_RIPPLE_TABLE / period);
+        std::vector<float> sums(size_t(nrows) * ncols * 3 * (dim + 1));
+        gathers[dim](input, &offsets[0], indices.data(), weights.data(), positions.data(), scale, &ripple[0], &sums[0]);
+
+        cv::Mat frame(nrows, ncols, input.type());
+        for (int f = 0; f < frames; f++) {
+            const double phase = 2.0 * PI * f / frames;
+            blends[dim](input, &sums[0], static_cast<float>(cos(phase)), static_cast<float>(sin(phase)), &frame);
+            callback(f, frame);
         }
     }
 
+    void lic(cv::OutputArray out, cv::InputArray img, const cv::Mat& vfield, int L, LicAlgo algo_type) {
+        msg_assert(vfield.depth() == CV_32F && vfield.channels() == 2, "Format of input vector field is invalid.");
+        licWithField(out, img, vfield, L, algo_type);
+    }
+
+    void lic(cv::OutputArray out, cv::InputArray img, const CompactVectorField& vfield, int L, LicAlgo algo_type) {
+        msg_assert(vfield.rows() == img.rows() && vfield.cols() == img.cols(),
+            "Vector field must have the same size as the input image.");
+        licWithField(out, img, vfield, L, algo_type);
+    }
+
+    void lic(cv::OutputArray out, cv::InputArray img, const StreamlineCache& cache) {
+        LIME_PROFILE_SCOPE("lic");
+        LIME_PROFILE_COUNT("pixels", img.rows() * img.cols());
+        cv::Mat tmp = licInput(img);
+        licWithCache(&tmp, &out.getMatRef(), cache);
+    }
+
+    void licAnimation(cv::InputArray img, const StreamlineCache& cache, int frames,
+                      const LicFrameCallback& callback, double period) {
+        LIME_PROFILE_COUNT("pixels", img.rows() * img.cols());
+        LIME_PROFILE_COUNT("frames", frames);
+        cv::Mat tmp = licInput(img);
+        cache.animate(tmp, frames, period > 0.0 ? period : cache.length(), callback);
+    }
+
     void vector2angle(cv::InputArray vfield, cv::OutputArray angle) {
         msg_assert(vfield.depth() == CV_32F && vfield.channels() == 2, "Format of input vector field is invalid.");
 
@@ -299,13 +936,13 @@ namespace { // NOLINT
         const int height = V.rows;
         cv::Mat& A = angle.getMatRef();
         A = cv::Mat(height, width, CV_32FC1);
-        for (int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](int y) {
+            const float* v = V.ptr<float>(y);
+            float* a = A.ptr<float>(y);
             for (int x = 0; x < width; x++) {
-                double vx = V.at<float>(y, x * 2 + 0);
-                double vy = V.at<float>(y, x * 2 + 1);
-                A.at<float>(y, x) = static_cast<float>(atan2(vy, vx));
+                a[x] = fastAtan2(v[x * 2 + 1], v[x * 2 + 0]);
             }
-        }
+        });
     }
 
     void angle2vector(cv::InputArray angle, cv::OutputArray vfield, double scale) {
@@ -314,15 +951,19 @@ namespace { // NOLINT
         cv::Mat A = angle.getMat();
         const int width = A.cols;
         const int height = A.rows;
+        const float length = static_cast<float>(scale);
         cv::Mat& T = vfield.getMatRef();
         T = cv::Mat(height, width, CV_32FC2);
-        for (int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](int y) {
+            const float* a = A.ptr<float>(y);
+            float* t = T.ptr<float>(y);
             for (int x = 0; x < width; x++) {
-                float theta = A.at<float>(y, x);
-                T.at<float>(y, x * 2 + 0) = static_cast<float>(scale * cos(theta));
-                T.at<float>(y, x * 2 + 1) = static_cast<float>(scale * sin(theta));
+                float s, c;
+                fastSinCos(a[x], &s, &c);
+                t[x * 2 + 0] = length * c;
+                t[x * 2 + 1] = length * s;
             }
-        }
+        });
     }
 
 }  // namespace npr
@@ -25,12 +25,17 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "NPREdges.h"
 #include "PoissonDisk.h"
 #include "Tensor.hpp"
+#include "TensorField.h"
+#include "ImageAnalysis.h"
 #include "Singularity.hpp"
 
 #include "Noise.h"
 #include "NPRFilters.h"
 
 #include "VectorField.h"
+#include "VectorFieldEstimator.h"
+#include "CompactVectorField.h"
 #include "../npr/lic.h"
+#include "Halo.h"
 
 #endif  // SRC_NPR_LIME_NPR_HPP_
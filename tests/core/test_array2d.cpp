@@ -19,6 +19,10 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 ******************************************************************************/
 
+#include <cstdint>
+#include <string>
+#include <utility>
+
 #include "gtest/gtest.h"
 
 #include "../../include/lime.hpp"
@@ -70,6 +74,74 @@ TEST_F(Array2dTest, OperatorEq) {
     EXPECT_NE(array2d(5, 5), 0);
 }
 
+TEST_F(Array2dTest, SelfAssignment) {
+    array2d = Array2d<int>(10, 10, 3);
+    Array2d<int>& self = array2d;
+    array2d = self;
+    EXPECT_EQ(array2d.rows(), 10);
+    EXPECT_EQ(array2d(9, 9), 3);
+}
+
+TEST_F(Array2dTest, MoveOperation) {
+    Array2d<int> temp(10, 20, 7);
+    int* p = temp.ptr(0);
+    array2d = std::move(temp);
+    EXPECT_EQ(array2d.ptr(0), p);
+    EXPECT_EQ(array2d(9, 19), 7);
+    EXPECT_EQ(temp.rows(), 0);
+
+    Array2d<int> moved(std::move(array2d));
+    EXPECT_EQ(moved.ptr(0), p);
+    EXPECT_EQ(array2d.cols(), 0);
+}
+
+TEST_F(Array2dTest, NonTrivialType) {
+    Array2d<std::string> strs(3, 4, "lime");
+    Array2d<std::string> copied = strs;
+    copied(1, 2) += "!";
+    EXPECT_EQ(strs(1, 2), "lime");
+    EXPECT_EQ(copied(1, 2), "lime!");
+    EXPECT_EQ(strs(2, 3), "lime");
+}
+
+TEST_F(Array2dTest, AlignedRows) {
+    Array2d<float> ary(5, 13, 1.0f, true);
+    EXPECT_EQ(ary.step() % 16, 0);
+    for (int i = 0; i < ary.rows(); i++) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ary.ptr(i)) % Array2d<float>::ALIGNMENT, 0u);
+        EXPECT_EQ(ary.row(i).size(), 13);
+        float sum = 0.0f;
+        for (float v : ary.row(i)) sum += v;
+        EXPECT_EQ(sum, 13.0f);
+    }
+}
+
+TEST_F(Array2dTest, MatView) {
+    Array2d<float> ary(4, 6, 0.0f, true);
+    cv::Mat mat = ary.asMat();
+    EXPECT_EQ(mat.rows, 4);
+    EXPECT_EQ(mat.cols, 6);
+    EXPECT_EQ(mat.type(), CV_32FC1);
+    mat.at<float>(2, 3) = 5.0f;
+    EXPECT_EQ(ary(2, 3), 5.0f);
+
+    Array2d<float> view;
+    {
+        cv::Mat buffer(3, 5, CV_32FC1, cv::Scalar(0.0));
+        view = Array2d<float>::fromMat(buffer);
+        buffer.at<float>(1, 4) = 2.0f;
+    }
+    // the buffer is kept alive by the view
+    EXPECT_EQ(view.rows(), 3);
+    EXPECT_EQ(view(1, 4), 2.0f);
+
+    // copies of a view own their elements
+    Array2d<float> copied = view;
+    copied(1, 4) = 0.0f;
+    EXPECT_EQ(view(1, 4), 2.0f);
+
+    ASSERT_DEATH(Array2d<int>::fromMat(cv::Mat(3, 3, CV_32FC1)), "");
+}
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
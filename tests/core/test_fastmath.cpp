@@ -0,0 +1,84 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+namespace {
+
+const double tolerance = 4.0e-7;
+
+}  // anonymous namespace
+
+TEST(FastMath, Atan2) {
+    double maxError = 0.0;
+    const int n = 1000;
+    for (int i = 0; i < n; i++) {
+        const double phi = 2.0 * PI * i / n - PI;
+        for (double r = 0.01; r < 200.0; r *= 3.0) {
+            const float x = static_cast<float>(r * cos(phi));
+            const float y = static_cast<float>(r * sin(phi));
+            maxError = std::max(maxError, std::abs(lime::fastAtan2(y, x) - atan2(y, x)));
+        }
+    }
+    EXPECT_LT(maxError, tolerance);
+}
+
+TEST(FastMath, Atan2Axes) {
+    EXPECT_EQ(lime::fastAtan2(0.0f, 0.0f), 0.0f);
+    EXPECT_EQ(lime::fastAtan2(0.0f, 1.0f), 0.0f);
+    EXPECT_NEAR(lime::fastAtan2(1.0f, 0.0f), PI / 2.0, tolerance);
+    EXPECT_NEAR(lime::fastAtan2(0.0f, -1.0f), PI, tolerance);
+    EXPECT_NEAR(lime::fastAtan2(-1.0f, 0.0f), -PI / 2.0, tolerance);
+    EXPECT_NEAR(lime::fastAtan2(1.0f, 1.0f), PI / 4.0, tolerance);
+}
+
+TEST(FastMath, SinCos) {
+    double maxError = 0.0;
+    const int n = 100000;
+    for (int i = 0; i <= n; i++) {
+        const float theta = static_cast<float>(4.0 * PI * i / n - 2.0 * PI);
+        float s, c;
+        lime::fastSinCos(theta, &s, &c);
+        maxError = std::max(maxError, std::abs(s - sin(static_cast<double>(theta))));
+        maxError = std::max(maxError, std::abs(c - cos(static_cast<double>(theta))));
+    }
+    EXPECT_LT(maxError, tolerance);
+}
+
+TEST(FastMath, SinCosRoundTrip) {
+    const int n = 1000;
+    for (int i = 0; i < n; i++) {
+        const float theta = static_cast<float>(2.0 * PI * i / n - PI + 0.5 / n);
+        float s, c;
+        lime::fastSinCos(theta, &s, &c);
+        EXPECT_NEAR(lime::fastAtan2(s, c), theta, 2.0 * tolerance);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
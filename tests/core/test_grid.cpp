@@ -19,6 +19,8 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 ******************************************************************************/
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "../../include/lime.hpp"
@@ -82,6 +84,84 @@ TEST_F(GridTest, HasCell) {
     EXPECT_FALSE(grid.hasCell(-1, -1));
 }
 
+TEST_F(GridTest, Growth) {
+    grid.resize(3, 3);
+    for (int k = 0; k < 100; k++) {
+        grid.pushAt(1, 1, k);
+        grid.pushAt(2, 0, -k);
+    }
+    EXPECT_EQ(grid.sizeAt(1, 1), 100);
+    EXPECT_EQ(grid.sizeAt(0, 0), 0);
+    for (int k = 0; k < 100; k++) {
+        EXPECT_EQ(grid(1, 1)[k], k);
+        EXPECT_EQ(grid(2, 0)[k], -k);
+    }
+}
+
+TEST_F(GridTest, SkewedGrowth) {
+    // one cell overflows many times while the others keep a few items
+    grid.resize(50, 40);
+    for (int k = 0; k < 5000; k++) {
+        grid.pushAt(7, 3, k);
+        if (k % 100 == 0) {
+            grid.pushAt((k / 100) % 50, (k / 100) % 40, -k);
+        }
+    }
+    EXPECT_EQ(grid.sizeAt(7, 3), 5000);
+    for (int k = 0; k < 5000; k++) {
+        ASSERT_EQ(grid(7, 3)[k], k);
+    }
+    for (int k = 0; k < 5000; k += 100) {
+        const int i = (k / 100) % 50;
+        const int j = (k / 100) % 40;
+        if (i == 7 && j == 3) continue;
+        ASSERT_EQ(grid.sizeAt(i, j), 1);
+        EXPECT_EQ(grid(i, j)[0], -k);
+    }
+}
+
+struct GridPoint {
+    GridPoint() : x(0.0), y(0.0) {}
+    GridPoint(double x_, double y_) : x(x_), y(y_) {}
+    double x, y;
+};
+
+TEST_F(GridTest, RadiusQuery) {
+    const double cellSize = 4.0;
+    Grid<GridPoint> points(10, 10, cellSize);
+    std::vector<GridPoint> all;
+    for (int i = 0; i < 40; i++) {
+        for (int j = 0; j < 40; j++) {
+            GridPoint p(j + 0.5, i + 0.25);
+            points.push(p);
+            all.push_back(p);
+        }
+    }
+
+    const GridPoint centers[] = { GridPoint(20.0, 20.0), GridPoint(0.0, 0.0), GridPoint(39.0, 3.0) };
+    const double radii[] = { 0.5, 3.0, 7.5 };
+    for (const GridPoint& c : centers) {
+        for (double r : radii) {
+            int expected = 0;
+            for (size_t k = 0; k < all.size(); k++) {
+                const double dx = all[k].x - c.x;
+                const double dy = all[k].y - c.y;
+                if (dx * dx + dy * dy < r * r) expected++;
+            }
+
+            int count = 0;
+            EXPECT_TRUE(points.forEachWithin(c, r, [&](const GridPoint&) { count++; return true; }));
+            EXPECT_EQ(count, expected);
+            EXPECT_EQ(points.containsWithin(c, r), expected != 0);
+        }
+    }
+
+    // stop the query early
+    int visited = 0;
+    EXPECT_FALSE(points.forEachWithin(GridPoint(20.0, 20.0), 5.0, [&](const GridPoint&) { return ++visited < 3; }));
+    EXPECT_EQ(visited, 3);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,624 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+namespace {
+
+cv::Mat makeImage(int rows, int cols, int channels) {
+    cv::Mat img(rows, cols, CV_MAKETYPE(CV_32F, channels));
+    lime::Random& rand = lime::Random::getRNG();
+    for (int y = 0; y < rows; y++) {
+        float* p = img.ptr<float>(y);
+        for (int i = 0; i < cols * channels; i++) {
+            p[i] = static_cast<float>(rand.randReal());
+        }
+    }
+    return img;
+}
+
+// rotational field of unit speed around a point off the image center
+cv::Mat makeVortex(int rows, int cols) {
+    cv::Mat vfield(rows, cols, CV_32FC2);
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            const double dx = x - 0.4 * cols;
+            const double dy = y - 0.6 * rows;
+            const double r = std::max(sqrt(dx * dx + dy * dy), 1.0e-3);
+            vfield.at<cv::Vec2f>(y, x)[0] = static_cast<float>(-dy / r);
+            vfield.at<cv::Vec2f>(y, x)[1] = static_cast<float>(dx / r);
+        }
+    }
+    return vfield;
+}
+
+double maxAbsDiff(const cv::Mat& a, const cv::Mat& b) {
+    EXPECT_EQ(a.rows, b.rows);
+    EXPECT_EQ(a.cols, b.cols);
+    EXPECT_EQ(a.type(), b.type());
+    double ret = 0.0;
+    const int n = a.cols * a.channels();
+    for (int y = 0; y < a.rows; y++) {
+        const float* pa = a.ptr<float>(y);
+        const float* pb = b.ptr<float>(y);
+        for (int i = 0; i < n; i++) {
+            ret = std::max(ret, static_cast<double>(std::abs(pa[i] - pb[i])));
+        }
+    }
+    return ret;
+}
+
+double meanAbsDiff(const cv::Mat& a, const cv::Mat& b) {
+    double ret = 0.0;
+    const int n = a.cols * a.channels();
+    for (int y = 0; y < a.rows; y++) {
+        const float* pa = a.ptr<float>(y);
+        const float* pb = b.ptr<float>(y);
+        for (int i = 0; i < n; i++) {
+            ret += std::abs(pa[i] - pb[i]);
+        }
+    }
+    return ret / (n * a.rows);
+}
+
+// brute-force box LIC which averages the 2L+1 samples of the streamline of every pixel,
+// traced in the same way as FastLIC
+cv::Mat boxLic(const cv::Mat& img, const cv::Mat& vfield, int L) {
+    const int dim = img.channels();
+    cv::Mat out(img.rows, img.cols, img.type());
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            std::vector<double> sum(img.ptr<float>(y) + x * dim, img.ptr<float>(y) + (x + 1) * dim);
+            int count = 1;
+            for (int pm = -1; pm <= 1; pm += 2) {
+                const cv::Vec2f& v0 = vfield.at<cv::Vec2f>(y, x);
+                double tx = pm * v0[0];
+                double ty = pm * v0[1];
+                double px = x + 0.5;
+                double py = y + 0.5;
+                for (int k = 0; k < L; k++) {
+                    px += tx;
+                    py += ty;
+                    const int ix = static_cast<int>(floor(px));
+                    const int iy = static_cast<int>(floor(py));
+                    if (ix < 0 || iy < 0 || ix >= img.cols || iy >= img.rows) break;
+
+                    const cv::Vec2f& v = vfield.at<cv::Vec2f>(iy, ix);
+                    if (v[0] == 0.0f && v[1] == 0.0f) break;
+
+                    const float* p = img.ptr<float>(iy) + ix * dim;
+                    for (int c = 0; c < dim; c++) {
+                        sum[c] += p[c];
+                    }
+                    count++;
+
+                    const double inner = v[0] * tx + v[1] * ty;
+                    tx = inner < 0.0 ? -v[0] : v[0];
+                    ty = inner < 0.0 ? -v[1] : v[1];
+                }
+            }
+
+            float* o = out.ptr<float>(y) + x * dim;
+            for (int c = 0; c < dim; c++) {
+                o[c] = static_cast<float>(sum[c] / count);
+            }
+        }
+    }
+    return out;
+}
+
+// sample emitted by traceLanes
+struct Sample {
+    int px, py;
+    double w, s;
+    bool operator==(const Sample& q) const {
+        return px == q.px && py == q.py && w == q.w && s == q.s;
+    }
+};
+
+// streamlines from (x0, y), ..., (x0 + n - 1, y) traced in lock-step, and the number of the steps
+template <bool MIDPOINT>
+int64_t traceLanes(const cv::Mat& vfield, int x0, int y, int n, int L, const double* kernel,
+                   std::vector<Sample>* lanes) {
+    for (int i = 0; i < n; i++) lanes[i].clear();
+    return lime::npr::traceLanes<MIDPOINT>(lime::npr::fieldAccessor(vfield), vfield.cols, vfield.rows,
+        x0, y, n, L, kernel, [&](int i, int px, int py, double w, double s) {
+        const Sample sample = { px, py, w, s };
+        lanes[i].push_back(sample);
+    });
+}
+
+// gaussWithFlow in which each streamline is traced alone, as before the lanes were introduced
+cv::Mat gaussWithFlowReference(const cv::Mat& image, const cv::Mat& vfield, int ksize,
+                               double sigma_s, double sigma_t) {
+    const int width = image.cols;
+    const int height = image.rows;
+    const int dim = image.channels();
+    const int L = static_cast<int>(ksize * 1.5);
+    cv::Mat out = cv::Mat::zeros(height, width, CV_MAKETYPE(CV_32F, dim));
+    cv::Mat temp = cv::Mat::zeros(height, width, CV_MAKETYPE(CV_32F, dim));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const cv::Vec2f& t0 = vfield.at<cv::Vec2f>(y, x);
+            double weight = 0.0;
+            for (int t = -ksize; t <= ksize; t++) {
+                const int xx = static_cast<int>(x - 0.5 * t0[1] * t);
+                const int yy = static_cast<int>(y + 0.5 * t0[0] * t);
+                if (xx >= 0 && yy >= 0 && xx < width && yy < height) {
+                    const double w = exp(-t * t / sigma_t);
+                    for (int c = 0; c < dim; c++) {
+                        temp.at<float>(y, x * dim + c) += static_cast<float>(w * image.at<float>(yy, xx * dim + c));
+                    }
+                    weight += w;
+                }
+            }
+            for (int c = 0; c < dim; c++) {
+                temp.at<float>(y, x * dim + c) = temp.at<float>(y, x * dim + c) / static_cast<float>(weight);
+            }
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double weight = 0.0;
+            for (int pm = -1; pm <= 1; pm += 2) {
+                const cv::Vec2f& t0 = vfield.at<cv::Vec2f>(y, x);
+                double tx = pm * t0[0];
+                double ty = pm * t0[1];
+                double ptx = x + 0.5;
+                double pty = y + 0.5;
+                for (int l = 1; l < L; l++) {
+                    int px = static_cast<int>(ceil(ptx));
+                    int py = static_cast<int>(ceil(pty));
+                    if (px < 0 || py < 0 || px >= width || py >= height) break;
+
+                    const double w = exp(-l * l / sigma_s);
+                    for (int c = 0; c < dim; c++) {
+                        out.at<float>(y, x * dim + c) += static_cast<float>(w * temp.at<float>(py, px * dim + c));
+                    }
+                    weight += w;
+
+                    cv::Vec2f v = vfield.at<cv::Vec2f>(py, px);
+                    if (v[0] == 0.0f && v[1] == 0.0f) break;
+
+                    double inner = v[0] * tx + v[1] * ty;
+                    px = static_cast<int>(ceil(ptx + 0.5 * lime::sign(inner) * v[0]));
+                    py = static_cast<int>(ceil(pty + 0.5 * lime::sign(inner) * v[1]));
+                    if (px < 0 || py < 0 || px >= width || py >= height) break;
+
+                    v = vfield.at<cv::Vec2f>(py, px);
+                    inner = v[0] * tx + v[1] * ty;
+                    tx = lime::sign(inner) * v[0];
+                    ty = lime::sign(inner) * v[1];
+                    ptx += tx;
+                    pty += ty;
+                }
+            }
+
+            for (int c = 0; c < dim; c++) {
+                if (weight != 0.0) {
+                    out.at<float>(y, x * dim + c) = out.at<float>(y, x * dim + c) / static_cast<float>(weight);
+                } else {
+                    out.at<float>(y, x * dim + c) = temp.at<float>(y, x * dim + c);
+                }
+            }
+        }
+    }
+    return out;
+}
+
+// integral of the kernel of LIC_CLASSIC over [a, b] in a closed form
+double kernelIntegral(double a, double b) {
+    const double cc = 10.0;
+    const double dd = 5.0;
+    const double beta = PI / 8.0;
+    return 0.25 * (b - a + (sin(b * cc) - sin(a * dd)) / cc
+        + (sin(dd * b + beta) - sin(a * dd + beta)) / dd
+        + (sin(b * (cc - dd) - beta) - sin(a * (cc - dd) - beta)) / (2.0 * (cc - dd))
+        + (sin(b * (cc + dd) + beta) - sin(a * (cc + dd) + beta)) / (2.0 * (cc + dd)));
+}
+
+// next crossing of a pixel boundary found by advancing pt by 0.1v, as nextPoint did before it was iterative
+lime::Point2d nextPointReference(lime::Point2d pt, lime::Point2d v) {
+    const double eps = 1.0e-10;
+    const double inf = 1.0e10;
+    for (;;) {
+        double direct[4];
+        direct[0] = lime::sign(v.y) == 0 ? inf : (ceil(pt.y) - pt.y) / (std::abs(v.y) + eps);
+        direct[1] = lime::sign(v.y) == 0 ? inf : (pt.y - floor(pt.y)) / (std::abs(v.y) + eps);
+        direct[2] = lime::sign(v.x) == 0 ? inf : (ceil(pt.x) - pt.x) / (std::abs(v.x) + eps);
+        direct[3] = lime::sign(v.x) == 0 ? inf : (pt.x - floor(pt.x)) / (std::abs(v.x) + eps);
+        double se = inf;
+        for (int i = 0; i < 4; i++) {
+            if (lime::sign(direct[i]) > 0) se = std::min(se, direct[i]);
+        }
+
+        if (se <= 2.0) {
+            return pt + v * se;
+        }
+        pt = lime::Point2d(pt.x + v.x * 0.1, pt.y + v.y * 0.1);
+    }
+}
+
+// vortex whose vectors are scaled to the length
+cv::Mat scaleField(const cv::Mat& vfield, float length) {
+    cv::Mat ret = vfield.clone();
+    for (int y = 0; y < ret.rows; y++) {
+        float* v = ret.ptr<float>(y);
+        for (int i = 0; i < ret.cols * 2; i++) {
+            v[i] *= length;
+        }
+    }
+    return ret;
+}
+
+// one pass of LIC_CLASSIC at (x, y) with the closed-form kernel integral and the 0.1v stepping
+float classicReference(const cv::Mat& img, const cv::Mat& vfield, int x, int y, int L) {
+    double acc = 0.0;
+    double weight = 0.0;
+    for (int pm = -1; pm <= 1; pm += 2) {
+        double l = 0.0;
+        lime::Point2d pt(x + 0.5, y + 0.5);
+        for (int cnt = 0; l < L && cnt < lime::npr::CLASSIC_MAX_STEPS; cnt++) {
+            const int lx = static_cast<int>(ceil(pt.x));
+            const int ly = static_cast<int>(ceil(pt.y));
+            if (lx < 0 || ly < 0 || lx >= img.cols || ly >= img.rows) break;
+
+            const cv::Vec2f& v = vfield.at<cv::Vec2f>(ly, lx);
+            if (v[0] == 0.0f && v[1] == 0.0f) break;
+
+            const lime::Point2d npt = nextPointReference(pt, lime::Point2d(pm * v[0], pm * v[1]));
+            const double dl = hypot(npt.x - pt.x, npt.y - pt.y);
+            const double w = kernelIntegral(l, l + dl);
+            acc += w * img.at<float>(ly, lx);
+            weight += w;
+            l += dl;
+            pt = npt;
+        }
+    }
+    return weight != 0.0 ? static_cast<float>(acc / weight) : img.at<float>(y, x);
+}
+
+// maximum difference of one pass of LIC_CLASSIC from classicReference
+double classicError(const cv::Mat& img, const cv::Mat& vfield, int L) {
+    const lime::npr::KernelIntegral kw(L + lime::npr::CLASSIC_TABLE_MARGIN);
+    double error = 0.0;
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            double acc = 0.0;
+            double weight = 0.0;
+            lime::npr::traceClassic(lime::npr::fieldAccessor(vfield), img.cols, img.rows, x, y, L, kw,
+                [&](int px, int py, double w, double) {
+                acc += w * img.at<float>(py, px);
+                weight += w;
+            });
+            const float value = weight != 0.0 ? static_cast<float>(acc / weight) : img.at<float>(y, x);
+            error = std::max(error, static_cast<double>(std::abs(value - classicReference(img, vfield, x, y, L))));
+        }
+    }
+    return error;
+}
+
+// frame of animated LIC with the ripple phase shifted by 2 PI f / frames, in which the samples
+// of the streamlines are weighted directly by the ripple
+template <lime::npr::LicAlgo ALGO>
+cv::Mat rippleReference(const cv::Mat& img, const cv::Mat& vfield, int L, double period, int f, int frames) {
+    const int dim = img.channels();
+    const double phase = 2.0 * PI * f / frames;
+    const lime::npr::MatVectorField field = lime::npr::fieldAccessor(vfield);
+    const lime::npr::LicTracer<lime::npr::MatVectorField, ALGO> trace(field, img.cols, img.rows, L);
+    cv::Mat out(img.rows, img.cols, img.type());
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            std::vector<double> plain(dim + 1, 0.0), rippled(dim + 1, 0.0);
+            trace(x, y, 1, [&](int, int px, int py, double w, double s) {
+                const double r = w * (1.0 + cos(2.0 * PI * s / period + phase));
+                const float* p = img.ptr<float>(py) + px * dim;
+                for (int c = 0; c < dim; c++) {
+                    plain[c] += w * p[c];
+                    rippled[c] += r * p[c];
+                }
+                plain[dim] += w;
+                rippled[dim] += r;
+            });
+
+            float* o = out.ptr<float>(y) + x * dim;
+            for (int c = 0; c < dim; c++) {
+                if (rippled[dim] > 1.0e-4 * plain[dim]) {
+                    o[c] = static_cast<float>(rippled[c] / rippled[dim]);
+                } else if (plain[dim] != 0.0) {
+                    o[c] = static_cast<float>(plain[c] / plain[dim]);
+                } else {
+                    o[c] = img.ptr<float>(y)[x * dim + c];
+                }
+            }
+        }
+    }
+    return out;
+}
+
+// frames of animated LIC
+std::vector<cv::Mat> animate(const cv::Mat& img, const lime::npr::StreamlineCache& cache, int frames, double period) {
+    std::vector<cv::Mat> ret(frames);
+    lime::npr::licAnimation(img, cache, frames, [&](int f, const cv::Mat& frame) {
+        ret[f] = frame.clone();
+    }, period);
+    return ret;
+}
+
+}  // unnamed namespace
+
+class LicTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        lime::setNumThreads(4);
+    }
+
+    virtual void TearDown() {
+        lime::setNumThreads(0);
+    }
+};
+
+TEST_F(LicTest, CachedSameAsTraced) {
+    const int L = 15;
+    const cv::Mat vfield = makeVortex(90, 110);
+    const lime::npr::LicAlgo algos[] = {
+        lime::npr::LIC_CLASSIC, lime::npr::LIC_EULARIAN, lime::npr::LIC_RUNGE_KUTTA
+    };
+    const int channels[] = { 1, 2, 3, 4 };
+    for (int a = 0; a < 3; a++) {
+        const lime::npr::StreamlineCache cache(vfield, L, algos[a]);
+        for (int c = 0; c < 4; c++) {
+            const cv::Mat img = makeImage(vfield.rows, vfield.cols, channels[c]);
+
+            cv::Mat cached;
+            lime::npr::lic(cached, img, cache);
+
+            cv::Mat temp = img.clone();
+            cv::Mat traced;
+            lime::npr::licTraced(&temp, &traced, lime::npr::fieldAccessor(vfield), L, algos[a]);
+            EXPECT_LT(maxAbsDiff(cached, traced), 1.0e-5);
+        }
+    }
+}
+
+TEST_F(LicTest, InvalidArguments) {
+    // the checks are kept in the release build, since they guard the dispatch tables
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    const cv::Mat vfield = makeVortex(30, 40);
+    ASSERT_DEATH(lime::npr::StreamlineCache(vfield, 10, lime::npr::LIC_FAST), "");
+    ASSERT_DEATH(lime::npr::StreamlineCache(lime::npr::CompactVectorField(vfield), 10, lime::npr::LIC_FAST), "");
+
+    const lime::npr::StreamlineCache cache(vfield, 10);
+    cv::Mat out;
+    const cv::Mat img(vfield.rows, vfield.cols, CV_MAKETYPE(CV_32F, 5));
+    ASSERT_DEATH(lime::npr::lic(out, img, vfield, 10, lime::npr::LIC_EULARIAN), "");
+    ASSERT_DEATH(cache.convolve(img, &out), "");
+}
+
+TEST_F(LicTest, FastIndependentOfThreads) {
+    const int L = 15;
+    const cv::Mat vfield = makeVortex(90, 110);
+    const cv::Mat img = makeImage(vfield.rows, vfield.cols, 3);
+
+    cv::Mat single, multi;
+    lime::setNumThreads(1);
+    lime::npr::lic(single, img, vfield, L, lime::npr::LIC_FAST);
+    lime::setNumThreads(4);
+    lime::npr::lic(multi, img, vfield, L, lime::npr::LIC_FAST);
+    EXPECT_EQ(maxAbsDiff(single, multi), 0.0);
+}
+
+TEST_F(LicTest, FastKeepsConstant) {
+    const int L = 15;
+    cv::Mat vfield = makeVortex(90, 110);
+    for (int y = 40; y < 50; y++) {
+        for (int x = 20; x < 35; x++) {
+            vfield.at<cv::Vec2f>(y, x)[0] = 0.0f;
+            vfield.at<cv::Vec2f>(y, x)[1] = 0.0f;
+        }
+    }
+    const int channels[] = { 1, 3, 4 };
+    for (int c = 0; c < 3; c++) {
+        cv::Mat img(vfield.rows, vfield.cols, CV_MAKETYPE(CV_32F, channels[c]), cv::Scalar(0.7, 0.7, 0.7, 0.7));
+        cv::Mat out;
+        lime::npr::lic(out, img, vfield, L, lime::npr::LIC_FAST);
+        EXPECT_LT(maxAbsDiff(out, img), 1.0e-5);
+    }
+}
+
+TEST_F(LicTest, FastSameAsBoxLicOnUniformField) {
+    // streamlines of axis-aligned fields pass through the pixel centers, so that
+    // every pixel of a streamline gets the same samples as its own streamline
+    const int L = 10;
+    const cv::Mat img = makeImage(90, 110, 3);
+    for (int axis = 0; axis < 2; axis++) {
+        cv::Mat vfield(img.rows, img.cols, CV_32FC2);
+        for (int y = 0; y < img.rows; y++) {
+            for (int x = 0; x < img.cols; x++) {
+                vfield.at<cv::Vec2f>(y, x)[0] = axis == 0 ? 1.0f : 0.0f;
+                vfield.at<cv::Vec2f>(y, x)[1] = axis == 0 ? 0.0f : 1.0f;
+            }
+        }
+
+        cv::Mat fast;
+        lime::npr::lic(fast, img, vfield, L, lime::npr::LIC_FAST);
+        EXPECT_LT(maxAbsDiff(fast, boxLic(img, vfield, L)), 1.0e-5);
+    }
+}
+
+TEST_F(LicTest, FastCloseToBoxLic) {
+    // box-filtered noise of the other samples differs by about 0.08 on average
+    const int L = 10;
+    const cv::Mat vfield = makeVortex(90, 110);
+    const cv::Mat img = makeImage(vfield.rows, vfield.cols, 3);
+
+    cv::Mat fast;
+    lime::npr::lic(fast, img, vfield, L, lime::npr::LIC_FAST);
+    const cv::Mat box = boxLic(img, vfield, L);
+    EXPECT_LT(meanAbsDiff(fast, box), 0.04);
+    EXPECT_GT(meanAbsDiff(img, box), 0.2);
+}
+
+TEST_F(LicTest, LanesSameAsSingleTrace) {
+    // the zero vectors and the image borders mask out the lanes at different steps
+    const int L = 20;
+    cv::Mat vfield = makeVortex(45, 61);
+    for (int y = 20; y < 26; y++) {
+        for (int x = 10; x < 19; x++) {
+            vfield.at<cv::Vec2f>(y, x)[0] = 0.0f;
+            vfield.at<cv::Vec2f>(y, x)[1] = 0.0f;
+        }
+    }
+    std::vector<double> kernel(L);
+    for (int l = 0; l < L; l++) {
+        kernel[l] = exp(-l * l / 32.0);
+    }
+
+    std::vector<Sample> lanes[lime::npr::LIC_LANES];
+    std::vector<Sample> single[1];
+    for (int y = 0; y < vfield.rows; y++) {
+        for (int x0 = 0; x0 < vfield.cols; x0 += lime::npr::LIC_LANES) {
+            const int n = std::min(lime::npr::LIC_LANES, vfield.cols - x0);
+            for (int midpoint = 0; midpoint < 2; midpoint++) {
+                int64_t steps = midpoint ? traceLanes<true>(vfield, x0, y, n, L, &kernel[0], lanes)
+                                         : traceLanes<false>(vfield, x0, y, n, L, &kernel[0], lanes);
+                for (int i = 0; i < n; i++) {
+                    steps -= midpoint ? traceLanes<true>(vfield, x0 + i, y, 1, L, &kernel[0], single)
+                                      : traceLanes<false>(vfield, x0 + i, y, 1, L, &kernel[0], single);
+                    ASSERT_TRUE(lanes[i] == single[0]) << "lane " << i << " from (" << x0 << ", " << y << ")";
+                }
+                EXPECT_EQ(steps, 0);
+            }
+        }
+    }
+}
+
+TEST_F(LicTest, GaussWithFlowSameAsSingleTrace) {
+    cv::Mat vfield = makeVortex(50, 70);
+    for (int y = 10; y < 16; y++) {
+        for (int x = 40; x < 47; x++) {
+            vfield.at<cv::Vec2f>(y, x)[0] = 0.0f;
+            vfield.at<cv::Vec2f>(y, x)[1] = 0.0f;
+        }
+    }
+    const int channels[] = { 1, 3 };
+    for (int c = 0; c < 2; c++) {
+        const cv::Mat img = makeImage(vfield.rows, vfield.cols, channels[c]);
+        cv::Mat out;
+        lime::npr::gaussWithFlow(img, out, lime::npr::fieldAccessor(vfield), 10, 3.0, 2.0);
+        EXPECT_EQ(maxAbsDiff(out, gaussWithFlowReference(img, vfield, 10, 3.0, 2.0)), 0.0);
+    }
+}
+
+TEST_F(LicTest, KernelIntegralSameAsExact) {
+    const int L = 20;
+    const lime::npr::KernelIntegral kw(L + 4.0);
+    lime::Random& rand = lime::Random::getRNG();
+    double error = 0.0;
+    for (int i = 0; i < 100000; i++) {
+        // the steps of up to 2 from the arc lengths within the tables and beyond
+        const double a = rand.randReal() * (L + 8.0);
+        const double b = a + rand.randReal() * 2.0;
+        const double exact = lime::npr::kernelUpper(b) - lime::npr::kernelLower(a);
+        EXPECT_NEAR(exact, kernelIntegral(a, b), 1.0e-12);
+        error = std::max(error, std::abs(kw(a, b) - exact));
+    }
+    // each linear interpolation is off by at most (1/256)^2 / 8 * 7.5, the maximum slope of the kernel
+    EXPECT_LT(error, 3.0e-5);
+    EXPECT_EQ(kw(L + 5.0, L + 6.0), lime::npr::kernelUpper(L + 6.0) - lime::npr::kernelLower(L + 5.0));
+}
+
+TEST_F(LicTest, NextPointSameAsStepping) {
+    lime::Random& rand = lime::Random::getRNG();
+    const double lengths[] = { 0.05, 0.3, 1.0, 2.0 };
+    double error = 0.0;
+    for (int i = 0; i < 20000; i++) {
+        const double length = lengths[i % 4];
+        const double theta = 2.0 * PI * rand.randReal();
+        lime::Point2d v(length * cos(theta), length * sin(theta));
+        if (i % 10 == 0) v = lime::Point2d(i % 20 == 0 ? length : 0.0, i % 20 == 0 ? 0.0 : -length);
+
+        // the points on the lattice lines as well as inside the pixels
+        lime::Point2d pt(10.0 * rand.randReal(), 10.0 * rand.randReal());
+        if (i % 7 == 0) pt.x = floor(pt.x);
+        if (i % 11 == 0) pt.y = floor(pt.y);
+
+        const lime::Point2d p = lime::npr::nextPoint(pt, v);
+        const lime::Point2d q = nextPointReference(pt, v);
+        error = std::max(error, std::max(std::abs(p.x - q.x), std::abs(p.y - q.y)));
+    }
+    EXPECT_LT(error, 1.0e-6);
+}
+
+TEST_F(LicTest, ClassicSameAsStepping) {
+    // short vectors take many 0.1v advances to cross a pixel
+    const int L = 10;
+    const cv::Mat vfield = makeVortex(40, 50);
+    const cv::Mat img = makeImage(vfield.rows, vfield.cols, 1);
+    EXPECT_LT(classicError(img, vfield, L), 1.0e-4);
+    EXPECT_LT(classicError(img, scaleField(vfield, 0.05f), L), 1.0e-4);
+}
+
+TEST_F(LicTest, AnimationSameAsRipple) {
+    // frame f is compared with the ripple of frame f + frames, so that the sequence loops,
+    // and the period does not divide the arc lengths, which are rounded to the ripple table
+    const int L = 15;
+    const int frames = 6;
+    const double period = 7.3;
+    const cv::Mat vfield = makeVortex(40, 50);
+    const lime::npr::StreamlineCache cache(vfield, L, lime::npr::LIC_EULARIAN);
+    const int channels[] = { 1, 2, 3, 4 };
+    for (int c = 0; c < 4; c++) {
+        const cv::Mat img = makeImage(vfield.rows, vfield.cols, channels[c]);
+        const std::vector<cv::Mat> sequence = animate(img, cache, frames, period);
+        for (int f = 0; f < frames; f++) {
+            const cv::Mat expected =
+                rippleReference<lime::npr::LIC_EULARIAN>(img, vfield, L, period, f + frames, frames);
+            EXPECT_LT(meanAbsDiff(sequence[f], expected), 1.0e-4);
+            EXPECT_LT(maxAbsDiff(sequence[f], expected), 1.0e-3);
+        }
+        EXPECT_GT(meanAbsDiff(sequence[0], sequence[frames / 2]), 1.0e-2);
+    }
+}
+
+TEST_F(LicTest, AnimationPhases) {
+    // frame f of a sequence is frame 2f of the sequence with twice as many frames
+    const int L = 10;
+    const cv::Mat vfield = makeVortex(30, 40);
+    const lime::npr::StreamlineCache cache(vfield, L, lime::npr::LIC_RUNGE_KUTTA);
+    const cv::Mat img = makeImage(vfield.rows, vfield.cols, 3);
+    const std::vector<cv::Mat> sequence = animate(img, cache, 5, 0.0);
+    const std::vector<cv::Mat> doubled = animate(img, cache, 10, 0.0);
+    for (int f = 0; f < 5; f++) {
+        EXPECT_EQ(maxAbsDiff(sequence[f], doubled[2 * f]), 0.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+class ParallelTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        lime::setNumThreads(4);
+    }
+
+    virtual void TearDown() {
+        lime::setNumThreads(0);
+    }
+};
+
+TEST_F(ParallelTest, NumThreads) {
+    EXPECT_EQ(lime::getNumThreads(), 4);
+    lime::setNumThreads(2);
+    EXPECT_EQ(lime::getNumThreads(), 2);
+    lime::setNumThreads(-1);
+    EXPECT_EQ(lime::getNumThreads(), static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    lime::setNumThreads(0);
+    EXPECT_EQ(lime::getNumThreads(), static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+}
+
+TEST_F(ParallelTest, EveryIndexVisitedOnce) {
+    const int n = 100003;
+    const int grains[] = { 0, 1, 7, 1000, 1 << 20 };
+    for (int g = 0; g < 5; g++) {
+        std::vector<int> count(n, 0);
+        lime::parallel_for(0, n, [&](int i) {
+            count[i]++;
+        }, grains[g]);
+
+        for (int i = 0; i < n; i++) {
+            ASSERT_EQ(count[i], 1);
+        }
+    }
+}
+
+TEST_F(ParallelTest, EmptyRange) {
+    int count = 0;
+    lime::parallel_for(10, 10, [&](int i) { count++; });
+    lime::parallel_for(10, 0, [&](int i) { count++; });
+    lime::parallel_for_2d(0, 10, [&](int y, int x) { count++; });
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(ParallelTest, Parallel2d) {
+    const int rows = 123;
+    const int cols = 77;
+    std::vector<int> count(rows * cols, 0);
+    lime::parallel_for_2d(rows, cols, [&](int y, int x) {
+        count[y * cols + x]++;
+    }, 5);
+
+    for (int i = 0; i < rows * cols; i++) {
+        ASSERT_EQ(count[i], 1);
+    }
+}
+
+TEST_F(ParallelTest, NestedLoops) {
+    const int n = 64;
+    std::vector<int> count(n * n, 0);
+    lime::parallel_for(0, n, [&](int i) {
+        EXPECT_TRUE(lime::ThreadPool::inParallelRegion());
+        lime::parallel_for(0, n, [&](int j) {
+            count[i * n + j]++;
+        });
+    }, 1);
+
+    EXPECT_FALSE(lime::ThreadPool::inParallelRegion());
+    for (int i = 0; i < n * n; i++) {
+        ASSERT_EQ(count[i], 1);
+    }
+}
+
+TEST_F(ParallelTest, UnbalancedWork) {
+    const int n = 256;
+    std::vector<double> result(n, 0.0);
+    lime::parallel_for(0, n, [&](int i) {
+        double sum = 0.0;
+        for (int k = 0; k < i * i; k++) sum += 1.0;
+        result[i] = sum;
+    }, 1);
+
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(result[i], static_cast<double>(i * i));
+    }
+}
+
+TEST_F(ParallelTest, ExceptionPropagates) {
+    const int n = 1000;
+    std::vector<int> count(n, 0);
+    EXPECT_THROW(lime::parallel_for(0, n, [&](int i) {
+        if (i == n / 2) throw std::runtime_error("failure in task");
+        count[i]++;
+    }, 1), std::runtime_error);
+    EXPECT_FALSE(lime::ThreadPool::inParallelRegion());
+
+    // the pool is still usable and the calling thread takes part in later loops
+    std::fill(count.begin(), count.end(), 0);
+    bool inRegion = true;
+    lime::parallel_for(0, n, [&](int i) {
+        if (!lime::ThreadPool::inParallelRegion()) inRegion = false;
+        count[i]++;
+    }, 1);
+    EXPECT_TRUE(inRegion);
+    for (int i = 0; i < n; i++) {
+        ASSERT_EQ(count[i], 1);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <vector>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+namespace {
+
+// * horizontal ramp from dense (0) to sparse (1) samples
+cv::Mat makeRamp(int rows, int cols) {
+    cv::Mat gray(rows, cols, CV_32FC1);
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            gray.at<float>(y, x) = static_cast<float>(x) / (cols - 1);
+        }
+    }
+    return gray;
+}
+
+std::vector<cv::Point2f> sample(const cv::Mat& gray, int nThreads, double minRadius, double maxRadius) {
+    lime::setNumThreads(nThreads);
+    lime::Random::setSeed(31415);
+    std::vector<cv::Point2f> points;
+    lime::npr::poissonDisk(gray, &points, lime::npr::PDS_FAST_PARALLEL, minRadius, maxRadius);
+    return points;
+}
+
+}  // unnamed namespace
+
+class PoissonDiskTest : public ::testing::Test {
+ protected:
+    virtual void TearDown() {
+        lime::setNumThreads(0);
+    }
+};
+
+TEST_F(PoissonDiskTest, IndependentOfThreads) {
+    const double minRadius = 1.5;
+    const double maxRadius = 12.0;
+    const cv::Mat gray = makeRamp(150, 200);
+
+    const std::vector<cv::Point2f> single = sample(gray, 1, minRadius, maxRadius);
+    const std::vector<cv::Point2f> multi = sample(gray, 4, minRadius, maxRadius);
+    ASSERT_FALSE(single.empty());
+    ASSERT_EQ(single.size(), multi.size());
+    for (size_t i = 0; i < single.size(); i++) {
+        EXPECT_EQ(single[i].x, multi[i].x);
+        EXPECT_EQ(single[i].y, multi[i].y);
+    }
+}
+
+TEST_F(PoissonDiskTest, DiskProperty) {
+    const double minRadius = 1.5;
+    const double maxRadius = 12.0;
+    const cv::Mat gray = makeRamp(150, 200);
+    const std::vector<cv::Point2f> points = sample(gray, 4, minRadius, maxRadius);
+
+    // no sample lies in the disk of another, whose radius is given by the intensity
+    for (size_t i = 0; i < points.size(); i++) {
+        const double ri = minRadius + (maxRadius - minRadius) * gray.at<float>(points[i].y, points[i].x);
+        for (size_t j = i + 1; j < points.size(); j++) {
+            const double rj = minRadius + (maxRadius - minRadius) * gray.at<float>(points[j].y, points[j].x);
+            const double dx = points[i].x - points[j].x;
+            const double dy = points[i].y - points[j].y;
+            const double r = std::max(ri, rj);
+            ASSERT_GE(dx * dx + dy * dy, r * r);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#ifndef LIME_ENABLE_PROFILE
+#define LIME_ENABLE_PROFILE
+#endif
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+using lime::profile::Event;
+using lime::profile::Profiler;
+
+class ProfileTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        Profiler::getProfiler().clear();
+        Profiler::getProfiler().setEnabled(true);
+        lime::setNumThreads(4);
+    }
+
+    virtual void TearDown() {
+        Profiler::getProfiler().clear();
+        lime::setNumThreads(0);
+    }
+
+    static const Event* findEvent(const std::vector<Event>& events, const std::string& name) {
+        for (size_t i = 0; i < events.size(); i++) {
+            if (name == events[i].name) return &events[i];
+        }
+        return NULL;
+    }
+
+    static int64_t findCounter(const Event& ev, const std::string& name) {
+        for (size_t i = 0; i < ev.counters.size(); i++) {
+            if (name == ev.counters[i].first) return ev.counters[i].second;
+        }
+        return -1;
+    }
+};
+
+TEST_F(ProfileTest, NestedScopes) {
+    {
+        LIME_PROFILE_SCOPE("outer");
+        LIME_PROFILE_COUNT("pixels", 100);
+        {
+            LIME_PROFILE_SCOPE("inner");
+            LIME_PROFILE_COUNT("iterations", 3);
+        }
+        LIME_PROFILE_COUNT("pixels", 20);
+    }
+
+    std::vector<Event> events = Profiler::getProfiler().events();
+    ASSERT_EQ(events.size(), 2);
+
+    const Event* outer = findEvent(events, "outer");
+    const Event* inner = findEvent(events, "inner");
+    ASSERT_TRUE(outer != NULL);
+    ASSERT_TRUE(inner != NULL);
+    EXPECT_EQ(findCounter(*outer, "pixels"), 120);
+    EXPECT_EQ(findCounter(*outer, "iterations"), -1);
+    EXPECT_EQ(findCounter(*inner, "iterations"), 3);
+    EXPECT_LE(outer->start, inner->start);
+    EXPECT_GE(outer->start + outer->duration, inner->start + inner->duration);
+}
+
+TEST_F(ProfileTest, ParallelCounters) {
+    const int n = 10000;
+    {
+        LIME_PROFILE_SCOPE("loop");
+        lime::parallel_for(0, n, [&](int i) {
+            LIME_PROFILE_COUNT("steps", 1);
+        }, 16);
+    }
+
+    std::vector<Event> events = Profiler::getProfiler().events();
+    const Event* loop = findEvent(events, "loop");
+    ASSERT_TRUE(loop != NULL);
+    EXPECT_EQ(findCounter(*loop, "steps"), n);
+}
+
+TEST_F(ProfileTest, Disabled) {
+    Profiler::getProfiler().setEnabled(false);
+    {
+        LIME_PROFILE_SCOPE("disabled");
+        LIME_PROFILE_COUNT("pixels", 1);
+    }
+    EXPECT_TRUE(Profiler::getProfiler().events().empty());
+}
+
+TEST_F(ProfileTest, WriteTrace) {
+    {
+        LIME_PROFILE_SCOPE("trace");
+        LIME_PROFILE_COUNT("pixels", 42);
+    }
+
+    const std::string filename = "test_profile_trace.json";
+    lime::profile::writeTrace(filename);
+
+    std::ifstream ifs(filename.c_str());
+    ASSERT_TRUE(ifs.is_open());
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    ifs.close();
+    std::remove(filename.c_str());
+
+    const std::string json = ss.str();
+    EXPECT_EQ(json.find("{\"traceEvents\":["), 0);
+    EXPECT_NE(json.find("\"name\":\"trace\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"pixels\":42"), std::string::npos);
+}
+
+TEST_F(ProfileTest, Report) {
+    for (int i = 0; i < 3; i++) {
+        LIME_PROFILE_SCOPE("stage");
+        LIME_PROFILE_COUNT("iterations", 2);
+    }
+
+    std::stringstream ss;
+    lime::profile::report(&ss);
+    const std::string text = ss.str();
+    EXPECT_NE(text.find("stage"), std::string::npos);
+    EXPECT_NE(text.find("iterations: 6"), std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
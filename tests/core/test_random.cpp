@@ -19,6 +19,11 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 ******************************************************************************/
 
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
 #include "../../include/lime.hpp"
@@ -74,6 +79,163 @@ TEST(Random, RandNorm) {
     }
 }
 
+// Pearson's chi-squared statistic of normal samples for 34 bins ([-4, 4] by 0.25 and two tails)
+template <typename Sampler>
+double normalChiSquared(int n, Sampler sampler) {
+    const int nBins = 34;
+    std::vector<int> hist(nBins, 0);
+    for (int i = 0; i < n; i++) {
+        const double x = sampler();
+        int b = static_cast<int>(floor((x + 4.0) / 0.25)) + 1;
+        b = std::max(0, std::min(nBins - 1, b));
+        hist[b]++;
+    }
+
+    double chi2 = 0.0;
+    for (int b = 0; b < nBins; b++) {
+        const double lo = b == 0 ? -1.0e10 : -4.0 + (b - 1) * 0.25;
+        const double hi = b == nBins - 1 ? 1.0e10 : -4.0 + b * 0.25;
+        const double p = 0.5 * (erf(hi / sqrt(2.0)) - erf(lo / sqrt(2.0)));
+        const double expected = p * n;
+        chi2 += (hist[b] - expected) * (hist[b] - expected) / expected;
+    }
+    return chi2;
+}
+
+TEST(Random, NormalDistribution) {
+    // 99.9th percentile of chi-squared distribution with 33 degrees of freedom
+    const double threshold = 63.87;
+    const int n = 2000000;
+
+    Random r1(2015);
+    EXPECT_LT(normalChiSquared(n, [&]() { return r1.randNorm(); }), threshold);
+
+    Random r2(2016);
+    std::vector<float> values(n);
+    r2.fillNormal(&values[0], n);
+    int index = 0;
+    EXPECT_LT(normalChiSquared(n, [&]() { return values[index++]; }), threshold);
+
+    // samples beyond the base layer of Ziggurat (|x| > 3.4426)
+    Random r3(2017);
+    int nTail = 0;
+    for (int i = 0; i < n; i++) {
+        if (fabs(r3.randNorm()) > 3.442619855899) nTail++;
+    }
+    const double pTail = 1.0 - erf(3.442619855899 / sqrt(2.0));
+    EXPECT_NEAR(nTail, pTail * n, 4.0 * sqrt(pTail * n));
+}
+
+TEST(Random, Reproducible) {
+    Random r1(1234, 5);
+    Random r2(1234, 5);
+    for (int i = 0; i < nLoop; i++) {
+        ASSERT_EQ(r1.randUInt(), r2.randUInt());
+    }
+
+    Random::setSeed(42);
+    double first = Random::getRNG().randReal();
+    Random::getRNG(42);
+    EXPECT_EQ(Random::getRNG().randReal(), first);
+}
+
+TEST(Random, IndependentStreams) {
+    Random base(2015);
+    Random s1 = base.stream(0);
+    Random s2 = base.stream(1);
+    Random s3 = base.stream(0);
+
+    int nSame = 0;
+    for (int i = 0; i < nLoop; i++) {
+        unsigned int v1 = s1.randUInt();
+        unsigned int v2 = s2.randUInt();
+        ASSERT_EQ(v1, s3.randUInt());
+        if (v1 == v2) nSame++;
+    }
+    EXPECT_LT(nSame, 3);
+
+    // split advances the parent, so the children differ
+    Random c1 = base.split();
+    Random c2 = base.split();
+    EXPECT_NE(c1.randUInt(), c2.randUInt());
+}
+
+TEST(Random, FillSameAsScalar) {
+    // bulk generation continues the same sequence as scalar calls
+    Random r1(777, 3);
+    Random r2(777, 3);
+    const int n = 1000;
+    std::vector<float> buf(n);
+    std::vector<int> ibuf(n);
+    for (int t = 0; t < 3; t++) {
+        r1.randUInt();
+        r2.randUInt();
+        r1.fill(&buf[0], n - t);
+        for (int i = 0; i < n - t; i++) {
+            ASSERT_EQ(buf[i], static_cast<float>(r2.randUInt() >> 8) / 16777216.0f);
+        }
+        r1.fillInt(&ibuf[0], n - t, 17);
+        for (int i = 0; i < n - t; i++) {
+            ASSERT_EQ(ibuf[i], r2.randInt(17));
+        }
+    }
+}
+
+TEST(Random, FillInt) {
+    int nBins = 10;
+    std::vector<int> values(nLoop);
+    std::vector<int> countUp(nBins, 0);
+    rng.fillInt(&values[0], nLoop, nBins);
+    for (int i = 0; i < nLoop; i++) {
+        ASSERT_GE(values[i], 0);
+        ASSERT_LT(values[i], nBins);
+        countUp[values[i]]++;
+    }
+
+    for (int i = 0; i < nBins; i++) {
+        EXPECT_LT(abs(countUp[i] - nLoop / nBins), nLoop / (nBins * nBins));
+    }
+}
+
+TEST(Random, FillNormal) {
+    std::vector<float> values(nLoop + 1);
+    for (int t = 0; t < nTest; t++) {
+        rng.fillNormal(&values[0], nLoop + (t % 2));
+        double avg = 0.0;
+        double var = 0.0;
+        for (int i = 0; i < nLoop; i++) {
+            avg += values[i];
+            var += values[i] * values[i];
+        }
+        avg = avg / nLoop;
+        var = var / nLoop - avg * avg;
+        ASSERT_NEAR(avg, 0.0, 0.05);
+        ASSERT_NEAR(var, 1.0, 0.05);
+    }
+}
+
+TEST(Random, ThreadLocal) {
+    std::vector<unsigned int> values(4);
+    std::vector<Random*> rngs(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&values, &rngs, t]() {
+            rngs[t] = &Random::getRNG();
+            values[t] = rngs[t]->randUInt();
+        }));
+    }
+    for (int t = 0; t < 4; t++) {
+        threads[t].join();
+    }
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            EXPECT_NE(rngs[i], rngs[j]);
+            EXPECT_NE(values[i], values[j]);
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,120 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+namespace {
+
+// * tensor field whose (E - G, F) is (x - cx, sign * (y - cy))
+lime::npr::TensorField linearField(int rows, int cols, double cx, double cy, double sign) {
+    lime::npr::TensorField field(rows, cols);
+    for (int y = 0; y < rows; y++) {
+        float* E = field.E(y);
+        float* F = field.F(y);
+        float* G = field.G(y);
+        for (int x = 0; x < cols; x++) {
+            E[x] = static_cast<float>(x - cx);
+            F[x] = static_cast<float>(sign * (y - cy));
+            G[x] = 0.0f;
+        }
+    }
+    return field;
+}
+
+}  // unnamed namespace
+
+TEST(SingularityTest, Wedge) {
+    std::vector<lime::npr::SingularPoint> points;
+    lime::npr::detectSingular(linearField(20, 30, 12.3, 7.6, 1.0), &points);
+    ASSERT_EQ(points.size(), 1u);
+    EXPECT_EQ(points[0].x, 12);
+    EXPECT_EQ(points[0].y, 7);
+    EXPECT_EQ(points[0].type, SINGULAR_WEDGE);
+}
+
+TEST(SingularityTest, Trisector) {
+    std::vector<lime::npr::SingularPoint> points;
+    lime::npr::detectSingular(linearField(20, 30, 12.3, 7.6, -1.0), &points);
+    ASSERT_EQ(points.size(), 1u);
+    EXPECT_EQ(points[0].x, 12);
+    EXPECT_EQ(points[0].y, 7);
+    EXPECT_EQ(points[0].type, SINGULAR_TRISECTOR);
+}
+
+TEST(SingularityTest, SharedEdges) {
+    // zeros on the diagonal, vertical and horizontal edges, and on a vertex shared by six triangles
+    const double centers[][2] = { { 12.5, 7.5 }, { 12.0, 7.25 }, { 12.75, 7.0 }, { 12.0, 7.0 } };
+    for (int i = 0; i < 4; i++) {
+        for (int s = 0; s < 2; s++) {
+            const double sign = s == 0 ? 1.0 : -1.0;
+            std::vector<lime::npr::SingularPoint> points;
+            lime::npr::detectSingular(linearField(20, 30, centers[i][0], centers[i][1], sign), &points);
+            ASSERT_EQ(points.size(), 1u);
+            EXPECT_EQ(points[0].x, 12);
+            EXPECT_EQ(points[0].y, 7);
+            EXPECT_EQ(points[0].type, s == 0 ? SINGULAR_WEDGE : SINGULAR_TRISECTOR);
+        }
+    }
+}
+
+TEST(SingularityTest, OppositePairInOneQuad) {
+    // (E - G, F) is (x - 0.25, y - 0.25) in the upper left triangle of the quad
+    // and (0.75 - y, 0.75 - x) in the lower right one
+    const float u[2][2] = { { -0.25f, 0.75f }, { -0.25f, -0.25f } };
+    const float v[2][2] = { { -0.25f, -0.25f }, { 0.75f, -0.25f } };
+    lime::npr::TensorField field(2, 2);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            field.E(y)[x] = u[y][x];
+            field.F(y)[x] = v[y][x];
+            field.G(y)[x] = 0.0f;
+        }
+    }
+
+    std::vector<lime::npr::SingularPoint> points;
+    lime::npr::detectSingular(field, &points);
+    ASSERT_EQ(points.size(), 2u);
+    EXPECT_EQ(points[0].x, 0);
+    EXPECT_EQ(points[0].y, 0);
+    EXPECT_EQ(points[0].type, SINGULAR_WEDGE);
+    EXPECT_EQ(points[1].x, 0);
+    EXPECT_EQ(points[1].y, 0);
+    EXPECT_EQ(points[1].type, SINGULAR_TRISECTOR);
+}
+
+TEST(SingularityTest, CompatibleOverloads) {
+    lime::npr::TensorField field = linearField(20, 30, 12.3, 7.6, 1.0);
+    std::vector<lime::npr::SingularPoint> points;
+    std::vector<cv::Point2f> nodes;
+    lime::npr::detectSingular(field, &points, &nodes);
+    ASSERT_EQ(points.size(), 1u);
+    EXPECT_EQ(points[0].x, 12);
+    EXPECT_EQ(points[0].y, 7);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,363 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <vector>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+namespace {
+
+// box filter whose border pixels average only the pixels inside the image
+void boxFilter(const cv::Mat& img, cv::OutputArray output, int radius) {
+    cv::Mat& out = output.getMatRef();
+    out = cv::Mat(img.rows, img.cols, CV_32FC1);
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            double sum = 0.0;
+            int cnt = 0;
+            for (int dy = -radius; dy <= radius; dy++) {
+                for (int dx = -radius; dx <= radius; dx++) {
+                    int xx = x + dx;
+                    int yy = y + dy;
+                    if (xx >= 0 && yy >= 0 && xx < img.cols && yy < img.rows) {
+                        sum += img.at<float>(yy, xx);
+                        cnt++;
+                    }
+                }
+            }
+            out.at<float>(y, x) = static_cast<float>(sum / cnt);
+        }
+    }
+}
+
+cv::Mat makeImage(int rows, int cols) {
+    cv::Mat img(rows, cols, CV_32FC1);
+    lime::Random& rand = lime::Random::getRNG();
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            img.at<float>(y, x) = static_cast<float>(rand.randReal());
+        }
+    }
+    return img;
+}
+
+cv::Mat makeColorImage(int rows, int cols) {
+    cv::Mat img(rows, cols, CV_32FC3);
+    lime::Random& rand = lime::Random::getRNG();
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            for (int c = 0; c < 3; c++) {
+                img.at<cv::Vec3f>(y, x)[c] = static_cast<float>(rand.randReal());
+            }
+        }
+    }
+    return img;
+}
+
+// flat regions next to strong edges, with faint noise in the upper half, so that
+// the tensors range from zero and tiny values to large ones
+cv::Mat makeEdgeImage(int rows, int cols) {
+    cv::Mat img(rows, cols, CV_32FC3);
+    lime::Random& rand = lime::Random::getRNG();
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            const int dx = x - cols / 2;
+            const int dy = y - rows / 2;
+            const bool inside = dx * dx + dy * dy < rows * rows / 8;
+            const float base = inside ? 0.9f : (x < cols / 3 ? 0.1f : 0.4f);
+            for (int c = 0; c < 3; c++) {
+                const float faint = y < rows / 2 ? static_cast<float>(1.0e-5 * rand.randReal()) : 0.0f;
+                img.at<cv::Vec3f>(y, x)[c] = base + faint;
+            }
+        }
+    }
+    return img;
+}
+
+// rotational field of unit speed around a point off the image center
+cv::Mat makeVortex(int rows, int cols) {
+    cv::Mat vfield(rows, cols, CV_32FC2);
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            const double dx = x - 0.4 * cols;
+            const double dy = y - 0.6 * rows;
+            const double r = std::max(sqrt(dx * dx + dy * dy), 1.0e-3);
+            vfield.at<cv::Vec2f>(y, x)[0] = static_cast<float>(-dy / r);
+            vfield.at<cv::Vec2f>(y, x)[1] = static_cast<float>(dx / r);
+        }
+    }
+    return vfield;
+}
+
+// maximum and mean absolute differences over all channels
+double absDiff(const cv::Mat& a, const cv::Mat& b, double* mean = NULL) {
+    EXPECT_EQ(a.rows, b.rows);
+    EXPECT_EQ(a.cols, b.cols);
+    EXPECT_EQ(a.type(), b.type());
+    double ret = 0.0;
+    double sum = 0.0;
+    const int n = a.cols * a.channels();
+    for (int y = 0; y < a.rows; y++) {
+        const float* pa = a.ptr<float>(y);
+        const float* pb = b.ptr<float>(y);
+        for (int i = 0; i < n; i++) {
+            const double d = std::abs(pa[i] - pb[i]);
+            ret = std::max(ret, d);
+            sum += d;
+        }
+    }
+    if (mean != NULL) *mean = sum / (static_cast<double>(a.rows) * n);
+    return ret;
+}
+
+}  // unnamed namespace
+
+class TilingTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        lime::setNumThreads(4);
+    }
+
+    virtual void TearDown() {
+        lime::setNumThreads(0);
+    }
+};
+
+TEST_F(TilingTest, TilesCoverImage) {
+    const cv::Size size(103, 77);
+    const int halo = 3;
+    std::vector<lime::Tile> tiles = lime::makeTiles(size, 16, halo);
+
+    std::vector<int> count(size.area(), 0);
+    for (size_t i = 0; i < tiles.size(); i++) {
+        const lime::Tile& t = tiles[i];
+        EXPECT_LE(t.roi.width, 16);
+        EXPECT_LE(t.roi.height, 16);
+        EXPECT_EQ(t.region.x, std::max(t.roi.x - halo, 0));
+        EXPECT_EQ(t.region.y, std::max(t.roi.y - halo, 0));
+        EXPECT_EQ(t.region.x + t.region.width, std::min(t.roi.x + t.roi.width + halo, size.width));
+        EXPECT_EQ(t.region.y + t.region.height, std::min(t.roi.y + t.roi.height + halo, size.height));
+        for (int y = t.roi.y; y < t.roi.y + t.roi.height; y++) {
+            for (int x = t.roi.x; x < t.roi.x + t.roi.width; x++) {
+                count[y * size.width + x]++;
+            }
+        }
+    }
+
+    for (int i = 0; i < size.area(); i++) {
+        ASSERT_EQ(count[i], 1);
+    }
+}
+
+TEST_F(TilingTest, SameAsWholeImage) {
+    const int radius = 2;
+    cv::Mat img = makeImage(70, 95);
+
+    cv::Mat expected;
+    boxFilter(img, expected, radius);
+
+    cv::Mat actual;
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        boxFilter(in, out, radius);
+    }, radius, 16);
+
+    ASSERT_EQ(actual.rows, expected.rows);
+    ASSERT_EQ(actual.cols, expected.cols);
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            ASSERT_EQ(actual.at<float>(y, x), expected.at<float>(y, x));
+        }
+    }
+}
+
+TEST_F(TilingTest, InPlace) {
+    const int radius = 1;
+    cv::Mat img = makeImage(40, 50);
+
+    cv::Mat expected;
+    boxFilter(img, expected, radius);
+
+    lime::tiledFilter(img, img, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        boxFilter(in, out, radius);
+    }, radius, 8);
+
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            ASSERT_EQ(img.at<float>(y, x), expected.at<float>(y, x));
+        }
+    }
+}
+
+TEST_F(TilingTest, KuwaharaFilters) {
+    const int ksize = 5;
+    cv::Mat img = makeColorImage(90, 110);
+
+    cv::Mat expected, actual;
+    lime::npr::filter::kuwaharaFilter(img, expected, ksize);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::kuwaharaFilter(in, out, ksize);
+    }, lime::npr::halo::kuwahara(ksize), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+
+    lime::npr::filter::anisoKF(img, expected, 8, ksize);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::anisoKF(in, out, 8, ksize);
+    }, lime::npr::halo::anisoKF(ksize), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+}
+
+TEST_F(TilingTest, AnisoKFFlatAndEdges) {
+    const int ksize = 5;
+    cv::Mat img = makeEdgeImage(90, 110);
+
+    cv::Mat expected, actual;
+    lime::npr::filter::anisoKF(img, expected, 8, ksize);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::anisoKF(in, out, 8, ksize);
+    }, lime::npr::halo::anisoKF(ksize), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+
+    lime::npr::calcVectorField(img, expected, ksize);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::calcVectorField(in, out, ksize);
+    }, lime::npr::halo::vectorField(ksize), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+}
+
+TEST_F(TilingTest, GeneralKF) {
+    const int ksize = 5;
+    cv::Mat img = makeColorImage(90, 110);
+
+    cv::Mat expected, actual;
+    lime::npr::filter::generalKF(img, expected, 8, ksize);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::generalKF(in, out, 8, ksize);
+    }, lime::npr::halo::generalKF(ksize), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+}
+
+TEST_F(TilingTest, MorphologicalFilters) {
+    typedef void (*Morphology)(cv::InputArray, cv::OutputArray, int);
+    const Morphology filters[] = {
+        lime::npr::filter::morphErode, lime::npr::filter::morphDilate, lime::npr::filter::morphOpen,
+        lime::npr::filter::morphClose, lime::npr::filter::morphGradient, lime::npr::filter::morphTophat,
+        lime::npr::filter::morphBlackhat
+    };
+    const int ksize = 3;
+    cv::Mat img = makeColorImage(90, 110);
+    for (int i = 0; i < 7; i++) {
+        cv::Mat expected, actual;
+        filters[i](img, expected, ksize);
+        lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+            filters[i](in, out, ksize);
+        }, lime::npr::halo::morphology(ksize), 32);
+        EXPECT_EQ(absDiff(actual, expected), 0.0);
+    }
+}
+
+TEST_F(TilingTest, VectorField) {
+    const lime::npr::VFieldType types[] = {
+        lime::npr::VECTOR_SST, lime::npr::VECTOR_ETF, lime::npr::VECTOR_ETF_SEPARABLE
+    };
+    const int ksize = 5;
+    cv::Mat img = makeColorImage(90, 110);
+    for (int i = 0; i < 3; i++) {
+        cv::Mat expected, actual;
+        lime::npr::calcVectorField(img, expected, ksize, types[i]);
+        lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+            lime::npr::calcVectorField(in, out, ksize, types[i]);
+        }, lime::npr::halo::vectorField(ksize, types[i]), 32);
+        EXPECT_EQ(absDiff(actual, expected), 0.0);
+    }
+}
+
+TEST_F(TilingTest, EdgeDoG) {
+    cv::Mat img = makeImage(100, 120);
+    const lime::npr::DoGType types[] = { lime::npr::EDGE_XDOG, lime::npr::EDGE_FDOG };
+    for (int i = 0; i < 2; i++) {
+        const lime::npr::DoGParam param(4.5, 0.5, 0.95, 10.0, types[i]);
+        cv::Mat expected, actual;
+        lime::npr::edgeDoG(img, expected, param);
+        lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+            lime::npr::edgeDoG(in, out, param);
+        }, lime::npr::halo::edgeDoG(param), 32);
+        EXPECT_EQ(absDiff(actual, expected), 0.0);
+    }
+}
+
+TEST_F(TilingTest, PDEFilters) {
+    const int maxiter = 5;
+    cv::Mat img = makeColorImage(90, 110);
+
+    cv::Mat expected, actual;
+    lime::npr::filter::solveAD(img, expected, 0.1, maxiter);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::solveAD(in, out, 0.1, maxiter);
+    }, lime::npr::halo::solveAD(maxiter), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+
+    lime::npr::filter::solveSF(img, expected, 0.1, maxiter);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::solveSF(in, out, 0.1, maxiter);
+    }, lime::npr::halo::solveSF(maxiter), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+
+    lime::npr::filter::solveMCF(img, expected, 3.0, maxiter);
+    lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+        lime::npr::filter::solveMCF(in, out, 3.0, maxiter);
+    }, lime::npr::halo::solveMCF(maxiter), 32);
+    EXPECT_EQ(absDiff(actual, expected), 0.0);
+}
+
+TEST_F(TilingTest, LIC) {
+    const int L = 10;
+    cv::Mat img = makeImage(100, 120);
+    cv::Mat vfield = makeVortex(img.rows, img.cols);
+
+    const lime::npr::LicAlgo algos[] = {
+        lime::npr::LIC_CLASSIC, lime::npr::LIC_EULARIAN, lime::npr::LIC_RUNGE_KUTTA, lime::npr::LIC_FAST
+    };
+    for (int a = 0; a < 4; a++) {
+        const lime::npr::LicAlgo algo = algos[a];
+        cv::Mat expected, actual;
+        lime::npr::lic(expected, img, vfield, L, algo);
+        lime::tiledFilter(img, actual, [&](const cv::Mat& in, cv::OutputArray out, const cv::Rect& region) {
+            lime::npr::lic(out, in, vfield(region), L, algo);
+        }, lime::npr::halo::lic(L, algo), 32);
+
+        double mean = 0.0;
+        const double diff = absDiff(actual, expected, &mean);
+        if (algo == lime::npr::LIC_CLASSIC || algo == lime::npr::LIC_FAST) {
+            // lattice crossings and streamline seeds depend on the absolute coordinates
+            EXPECT_LT(mean, 5.0e-2);
+        } else {
+            EXPECT_EQ(diff, 0.0);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+Copyright 2015 Tatsuya Yatagawa (tatsy)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "../../include/lime.hpp"
+
+namespace {
+
+cv::Mat makeColorImage(int rows, int cols) {
+    cv::Mat img(rows, cols, CV_32FC3);
+    lime::Random& rand = lime::Random::getRNG();
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            for (int c = 0; c < 3; c++) {
+                img.at<cv::Vec3f>(y, x)[c] = static_cast<float>(rand.randReal());
+            }
+        }
+    }
+    return img;
+}
+
+// flat regions next to strong edges, with faint noise in the upper half, so that
+// the tensors range from zero and tiny values to large ones
+cv::Mat makeEdgeImage(int rows, int cols) {
+    cv::Mat img(rows, cols, CV_32FC3);
+    lime::Random& rand = lime::Random::getRNG();
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            const int dx = x - cols / 2;
+            const int dy = y - rows / 2;
+            const bool inside = dx * dx + dy * dy < rows * rows / 8;
+            const float base = inside ? 0.9f : (x < cols / 3 ? 0.1f : 0.4f);
+            for (int c = 0; c < 3; c++) {
+                const float faint = y < rows / 2 ? static_cast<float>(1.0e-5 * rand.randReal()) : 0.0f;
+                img.at<cv::Vec3f>(y, x)[c] = base + faint;
+            }
+        }
+    }
+    return img;
+}
+
+// * paint a rectangle with a diagonal ramp
+void paintRect(cv::Mat* img, const cv::Rect& rect) {
+    for (int y = rect.y; y < rect.y + rect.height; y++) {
+        for (int x = rect.x; x < rect.x + rect.width; x++) {
+            const float v = static_cast<float>(0.7 * (x - rect.x) + 0.3 * (y - rect.y)) / rect.width;
+            img->at<cv::Vec3f>(y, x)[0] = v;
+            img->at<cv::Vec3f>(y, x)[1] = 1.0f - v;
+            img->at<cv::Vec3f>(y, x)[2] = 0.5f * v;
+        }
+    }
+}
+
+double maxAbsDiff(const cv::Mat& a, const cv::Mat& b) {
+    EXPECT_EQ(a.rows, b.rows);
+    EXPECT_EQ(a.cols, b.cols);
+    EXPECT_EQ(a.type(), b.type());
+    double ret = 0.0;
+    const int n = a.cols * a.channels();
+    for (int y = 0; y < a.rows; y++) {
+        const float* pa = a.ptr<float>(y);
+        const float* pb = b.ptr<float>(y);
+        for (int i = 0; i < n; i++) {
+            ret = std::max(ret, static_cast<double>(std::abs(pa[i] - pb[i])));
+        }
+    }
+    return ret;
+}
+
+}  // unnamed namespace
+
+class VectorFieldEstimatorTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        lime::setNumThreads(4);
+    }
+
+    virtual void TearDown() {
+        lime::setNumThreads(0);
+    }
+
+    // update the estimator after painting the rectangle, and compare it with the full recompute
+    void checkUpdate(const cv::Rect& dirty, const cv::Mat& original) {
+        const int ksize = 5;
+        cv::Mat img = original.clone();
+        lime::npr::VectorFieldEstimator estimator(ksize);
+        estimator.compute(img);
+
+        paintRect(&img, dirty);
+        const cv::Rect updated = estimator.update(img, dirty);
+        const int margin = estimator.footprint();
+        const cv::Rect expanded(dirty.x - margin, dirty.y - margin,
+                                dirty.width + 2 * margin, dirty.height + 2 * margin);
+        EXPECT_EQ(updated, expanded & cv::Rect(0, 0, img.cols, img.rows));
+
+        cv::Mat angles, vectors;
+        lime::npr::calcVectorField(img, angles, ksize, lime::npr::VECTOR_SST);
+        lime::npr::calcVectorField(img, vectors, ksize, lime::npr::VECTOR_SST, lime::npr::EDGE_SOBEL,
+                                   lime::npr::VFIELD_VECTORS);
+        EXPECT_EQ(maxAbsDiff(estimator.angles(), angles), 0.0);
+        EXPECT_EQ(maxAbsDiff(estimator.vectors(), vectors), 0.0);
+    }
+};
+
+TEST_F(VectorFieldEstimatorTest, ComputeSameAsFull) {
+    const int ksize = 7;
+    cv::Mat img = makeColorImage(60, 70);
+    lime::npr::VectorFieldEstimator estimator(ksize);
+    estimator.compute(img);
+
+    cv::Mat angles;
+    lime::npr::calcVectorField(img, angles, ksize, lime::npr::VECTOR_SST);
+    EXPECT_EQ(maxAbsDiff(estimator.angles(), angles), 0.0);
+}
+
+TEST_F(VectorFieldEstimatorTest, UpdateInterior) {
+    checkUpdate(cv::Rect(30, 25, 20, 15), makeColorImage(80, 100));
+}
+
+TEST_F(VectorFieldEstimatorTest, UpdateTouchingBorder) {
+    checkUpdate(cv::Rect(0, 50, 25, 30), makeColorImage(80, 100));
+    checkUpdate(cv::Rect(85, 0, 15, 10), makeColorImage(80, 100));
+}
+
+TEST_F(VectorFieldEstimatorTest, UpdateFlatAndEdges) {
+    checkUpdate(cv::Rect(30, 25, 20, 15), makeEdgeImage(80, 100));
+    checkUpdate(cv::Rect(0, 30, 20, 50), makeEdgeImage(80, 100));
+    checkUpdate(cv::Rect(60, 0, 40, 12), makeEdgeImage(80, 100));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}